@@ -22,6 +22,7 @@
 
 // Based on the ScummVM (GPLv2+) file of the same name
 
+#include "common/config-manager.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -48,7 +49,18 @@ public:
 	~Channel();
 
 	/**
-	 * Mixes the channel's samples into the given buffer.
+	 * Prepares the channel for the next mix() call. This records the time
+	 * stamps used by getElapsedTime() and takes the current volume, so it
+	 * must be called with the mixer's channel pool locked, like all other
+	 * calls changing or querying the channel.
+	 *
+	 * @return false when the channel has no data to mix
+	 */
+	bool prepareMix();
+
+	/**
+	 * Mixes the channel's samples into the given buffer. Only state private
+	 * to mixing is touched, so this runs without the channel pool locked.
 	 *
 	 * @param data buffer where to mix the data
 	 * @param len  number of sample *pairs*. So a value of
@@ -156,6 +168,7 @@ private:
 
 	void updateChannelVolumes();
 	st_volume_t _volL, _volR;
+	st_volume_t _mixVolL, _mixVolR; // Copy of _volL and _volR for mix()
 
 	Mixer *_mixer;
 
@@ -175,16 +188,15 @@ private:
 
 // TODO: parameter "system" is unused
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _mixMutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		_channels[i] = 0;
+	_channels.resize(kInitialChannels);
 }
 
 MixerImpl::~MixerImpl() {
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (uint i = 0; i != _channels.size(); i++)
 		delete _channels[i];
 }
 
@@ -198,22 +210,28 @@ uint MixerImpl::getOutputRate() const {
 
 void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	int index = -1;
-	for (int i = 0; i != NUM_CHANNELS; i++) {
+	for (uint i = 0; i != _channels.size(); i++) {
 		if (_channels[i] == 0) {
 			index = i;
 			break;
 		}
 	}
 	if (index == -1) {
-		warning("MixerImpl::out of mixer slots");
-		delete chan;
-		return;
+		if (_channels.size() >= kMaxChannels) {
+			warning("MixerImpl::out of mixer slots");
+			delete chan;
+			return;
+		}
+
+		// Grow the channel pool
+		index = _channels.size();
+		_channels.resize(MIN<uint>(_channels.size() * 2, kMaxChannels));
 	}
 
 	_channels[index] = chan;
 
 	SoundHandle chanHandle;
-	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
+	chanHandle._val = index + (_handleSeed * kMaxChannels);
 
 	chan->setHandle(chanHandle);
 	_handleSeed++;
@@ -221,6 +239,25 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 		*handle = chanHandle;
 }
 
+int MixerImpl::findChannel(SoundHandle handle) const {
+	const uint index = handle._val % kMaxChannels;
+	if (index >= _channels.size() || !_channels[index] || _channels[index]->getHandle()._val != handle._val)
+		return -1;
+
+	return index;
+}
+
+void MixerImpl::destroyChannels(const ChannelList &channels) {
+	if (channels.empty())
+		return;
+
+	// Wait for a running mixCallback() pass, which might still be mixing them
+	Common::StackLock lock(_mixMutex);
+
+	for (uint i = 0; i != channels.size(); i++)
+		delete channels[i];
+}
+
 void MixerImpl::playStream(
 			SoundType type,
 			SoundHandle *handle,
@@ -240,7 +277,7 @@ void MixerImpl::playStream(
 
 	// Prevent duplicate sounds
 	if (id != -1) {
-		for (int i = 0; i != NUM_CHANNELS; i++)
+		for (uint i = 0; i != _channels.size(); i++)
 			if (_channels[i] != 0 && _channels[i]->getId() == id) {
 				// Delete the stream if were asked to auto-dispose it.
 				// Note: This could cause trouble if the client code does not
@@ -269,7 +306,7 @@ void MixerImpl::playStream(
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
-	Common::StackLock lock(_mutex);
+	Common::StackLock mixLock(_mixMutex);
 
 	int16 *buf = (int16 *)samples;
 	// we store stereo, 16-bit samples
@@ -282,61 +319,92 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	//  zero the buf
 	memset(buf, 0, 2 * len * sizeof(int16));
 
+	// Collect the channels to mix. The channel pool is only locked for
+	// that, so that calls from other threads don't wait for the mixing.
+	uint mixCount = 0;
+	{
+		Common::StackLock lock(_mutex);
+
+		for (uint i = 0; i != _channels.size(); i++)
+			if (_channels[i]) {
+				if (_channels[i]->isFinished()) {
+					delete _channels[i];
+					_channels[i] = 0;
+				} else if (!_channels[i]->isPaused() && _channels[i]->prepareMix()) {
+					_mixChannels[mixCount++] = _channels[i];
+				}
+			}
+	}
+
 	// mix all channels
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i]) {
-			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = 0;
-			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
+	for (uint i = 0; i != mixCount; i++) {
+		tmp = _mixChannels[i]->mix(buf, len);
 
-				if (tmp > res)
-					res = tmp;
-			}
-		}
+		if (tmp > res)
+			res = tmp;
+	}
 
 	return res;
 }
 
 void MixerImpl::stopAll() {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
+	ChannelList stopped;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (uint i = 0; i != _channels.size(); i++) {
+			if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
+				stopped.push_back(_channels[i]);
+				_channels[i] = 0;
+			}
 		}
 	}
+
+	destroyChannels(stopped);
 }
 
 void MixerImpl::stopID(int id) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
+	ChannelList stopped;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (uint i = 0; i != _channels.size(); i++) {
+			if (_channels[i] != 0 && _channels[i]->getId() == id) {
+				stopped.push_back(_channels[i]);
+				_channels[i] = 0;
+			}
 		}
 	}
+
+	destroyChannels(stopped);
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	ChannelList stopped;
 
-	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+	{
+		Common::StackLock lock(_mutex);
+
+		// Simply ignore stop requests for handles of sounds that already terminated
+		const int index = findChannel(handle);
+		if (index == -1)
+			return;
+
+		stopped.push_back(_channels[index]);
+		_channels[index] = 0;
+	}
 
-	delete _channels[index];
-	_channels[index] = 0;
+	destroyChannels(stopped);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
+
+	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].mute = mute;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
+	for (uint i = 0; i != _channels.size(); ++i) {
 		if (_channels[i] && _channels[i]->getType() == type)
 			_channels[i]->notifyGlobalVolChange();
 	}
@@ -350,16 +418,18 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
 	_channels[index]->setVolume(volume);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_mutex);
+
+	const int index = findChannel(handle);
+	if (index == -1)
 		return 0;
 
 	return _channels[index]->getVolume();
@@ -368,16 +438,18 @@ byte MixerImpl::getChannelVolume(SoundHandle handle) {
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
 	_channels[index]->setBalance(balance);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_mutex);
+
+	const int index = findChannel(handle);
+	if (index == -1)
 		return 0;
 
 	return _channels[index]->getBalance();
@@ -390,8 +462,8 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 Common::Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return Common::Timestamp(0, _sampleRate);
 
 	return _channels[index]->getElapsedTime();
@@ -399,7 +471,7 @@ Common::Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 
 void MixerImpl::pauseAll(bool paused) {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
+	for (uint i = 0; i != _channels.size(); i++) {
 		if (_channels[i] != 0) {
 			_channels[i]->pause(paused);
 		}
@@ -408,7 +480,7 @@ void MixerImpl::pauseAll(bool paused) {
 
 void MixerImpl::pauseID(int id, bool paused) {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
+	for (uint i = 0; i != _channels.size(); i++) {
 		if (_channels[i] != 0 && _channels[i]->getId() == id) {
 			_channels[i]->pause(paused);
 			return;
@@ -420,8 +492,8 @@ void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 	Common::StackLock lock(_mutex);
 
 	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
 	_channels[index]->pause(paused);
@@ -430,7 +502,7 @@ void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 bool MixerImpl::isSoundIDActive(int id) {
 	Common::StackLock lock(_mutex);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (uint i = 0; i != _channels.size(); i++)
 		if (_channels[i] && _channels[i]->getId() == id)
 			return true;
 	return false;
@@ -438,8 +510,8 @@ bool MixerImpl::isSoundIDActive(int id) {
 
 int MixerImpl::getSoundID(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
+	const int index = findChannel(handle);
+	if (index != -1)
 		return _channels[index]->getId();
 	return 0;
 }
@@ -447,13 +519,12 @@ int MixerImpl::getSoundID(SoundHandle handle) {
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	return findChannel(handle) != -1;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (uint i = 0; i != _channels.size(); i++)
 		if (_channels[i] && _channels[i]->getType() == type)
 			return true;
 	return false;
@@ -474,7 +545,7 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].volume = volume;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
+	for (uint i = 0; i != _channels.size(); ++i) {
 		if (_channels[i] && _channels[i]->getType() == type)
 			_channels[i]->notifyGlobalVolChange();
 	}
@@ -495,13 +566,14 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
                  DisposeAfterUse::Flag autofreeStream, int id, bool permanent)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-      _pauseStartTime(0), _pauseTime(0), _converter(0), _volL(0), _volR(0),
+      _pauseStartTime(0), _pauseTime(0), _converter(0), _volL(0), _volR(0), _mixVolL(0), _mixVolR(0),
       _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo());
+	const RateConverterQuality quality = (ConfMan.get("resampling_quality") == "high") ? kRateConverterHighQuality : kRateConverterNormalQuality;
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), quality);
 }
 
 Channel::~Channel() {
@@ -599,21 +671,30 @@ Common::Timestamp Channel::getElapsedTime() {
 	return ts;
 }
 
-int Channel::mix(int16 *data, uint len) {
+bool Channel::prepareMix() {
 	assert(_stream);
 
-	int res = 0;
 	if (_stream->endOfData()) {
 		// TODO: call drain method
-	} else {
-		assert(_converter);
-		_samplesConsumed = _samplesDecoded;
-		_mixerTimeStamp = g_system->getMillis();
-		_pauseTime = 0;
-		res = _converter->flow(*_stream, data, len, _volL, _volR);
-		_samplesDecoded += res;
+		return false;
 	}
 
+	// _samplesDecoded belongs to the mixing pass, like everything mix() uses
+	_samplesConsumed = _samplesDecoded;
+	_mixerTimeStamp = g_system->getMillis();
+	_pauseTime = 0;
+
+	_mixVolL = _volL;
+	_mixVolR = _volR;
+	return true;
+}
+
+int Channel::mix(int16 *data, uint len) {
+	assert(_converter);
+
+	int res = _converter->flow(*_stream, data, len, _mixVolL, _mixVolR);
+	_samplesDecoded += res;
+
 	return res;
 }
 
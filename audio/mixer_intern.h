@@ -26,6 +26,7 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/mutex.h"
 #include "audio/mixer.h"
 
@@ -53,10 +54,24 @@ namespace Audio {
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 16
+		/** Number of channels allocated up front. */
+		kInitialChannels = 16,
+		/** Number of channels the channel pool can grow to. */
+		kMaxChannels = 256
 	};
 
+	typedef Common::Array<Channel *> ChannelList;
+
+	/**
+	 * Guards the channel pool and the state of the channels, including the
+	 * time stamps and volumes Channel::prepareMix() hands to the mixing.
+	 */
 	Common::Mutex _mutex;
+	/**
+	 * Held by mixCallback() while mixing, when _mutex is not held.
+	 * Channels are only destroyed while holding it.
+	 */
+	Common::Mutex _mixMutex;
 
 	const uint _sampleRate;
 	bool _mixerReady;
@@ -70,7 +85,12 @@ private:
 	};
 
 	SoundTypeSettings _soundTypeSettings[4];
-	Channel *_channels[NUM_CHANNELS];
+
+	/** The channel pool. Free slots are 0. */
+	ChannelList _channels;
+
+	/** The channels mixed in the current mixCallback() pass. */
+	Channel *_mixChannels[kMaxChannels];
 
 
 public:
@@ -122,6 +142,15 @@ public:
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+	/** Return the index of the channel playing the handle, or -1. Requires _mutex. */
+	int findChannel(SoundHandle handle) const;
+
+	/**
+	 * Destroy channels already removed from the pool, once they are
+	 * not being mixed anymore. Must not be called with _mutex held.
+	 */
+	void destroyChannels(const ChannelList &channels);
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
@@ -37,6 +37,11 @@
 #include "common/textconsole.h"
 #include "common/util.h"
 
+#if defined(__SSE2__) && !defined(OUTPUT_UNSIGNED_AUDIO)
+#define USE_SSE2_MIXING
+#include <emmintrin.h>
+#endif
+
 namespace Audio {
 
 
@@ -59,6 +64,135 @@ enum {
 	FRAC_HALF_LOW = (1L << (FRAC_BITS_LOW-1))
 };
 
+#ifdef USE_SSE2_MIXING
+
+/**
+ * Scale 8 samples by their volumes and saturate-add them to the output.
+ *
+ * Bit-exact with clampedAdd(out, (in * vol) / Audio::Mixer::kMaxMixerVolume).
+ */
+static inline void mixVector(st_sample_t *obuf, __m128i in, __m128i vol) {
+	// Full 32-bit products
+	const __m128i lo = _mm_mullo_epi16(in, vol);
+	const __m128i hi = _mm_mulhi_epi16(in, vol);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+
+	// Divide by kMaxMixerVolume (256), rounding towards zero like the C division
+	const __m128i bias = _mm_set1_epi32(Audio::Mixer::kMaxMixerVolume - 1);
+	p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), bias)), 8);
+	p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), bias)), 8);
+
+	// The scaled samples fit into 16 bits, so only the addition saturates
+	const __m128i out = _mm_adds_epi16(_mm_loadu_si128((const __m128i *)obuf), _mm_packs_epi32(p0, p1));
+	_mm_storeu_si128((__m128i *)obuf, out);
+}
+
+#endif // USE_SSE2_MIXING
+
+/**
+ * Mix a buffer of stereo samples into the output buffer, applying the
+ * volume of each channel.
+ *
+ * @param obuf  The output buffer, holding count sample pairs.
+ * @param ibuf  The input buffer, holding count sample pairs.
+ * @param count The number of sample pairs to mix.
+ */
+static void mixStereo(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t count, st_volume_t vol_l, st_volume_t vol_r) {
+#ifdef USE_SSE2_MIXING
+	const __m128i vol = _mm_set_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l);
+
+	for (; count >= 4; count -= 4) {
+		mixVector(obuf, _mm_loadu_si128((const __m128i *)ibuf), vol);
+
+		ibuf += 8;
+		obuf += 8;
+	}
+#endif
+
+	for (; count > 0; count--) {
+		clampedAdd(obuf[0], (ibuf[0] * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+		clampedAdd(obuf[1], (ibuf[1] * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		ibuf += 2;
+		obuf += 2;
+	}
+}
+
+/**
+ * Mix a buffer of mono samples into both channels of the output buffer,
+ * applying the volume of each channel.
+ *
+ * @param obuf  The output buffer, holding count sample pairs.
+ * @param ibuf  The input buffer, holding count samples.
+ * @param count The number of samples to mix.
+ */
+static void mixMono(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t count, st_volume_t vol_l, st_volume_t vol_r) {
+#ifdef USE_SSE2_MIXING
+	const __m128i vol = _mm_set_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l);
+
+	for (; count >= 8; count -= 8) {
+		const __m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+
+		// Duplicate every sample into a sample pair
+		mixVector(obuf,     _mm_unpacklo_epi16(in, in), vol);
+		mixVector(obuf + 8, _mm_unpackhi_epi16(in, in), vol);
+
+		ibuf += 8;
+		obuf += 16;
+	}
+#endif
+
+	for (; count > 0; count--) {
+		clampedAdd(obuf[0], (ibuf[0] * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+		clampedAdd(obuf[1], (ibuf[0] * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		ibuf += 1;
+		obuf += 2;
+	}
+}
+
+/**
+ * Base class for rate converters which resample their input into an
+ * intermediate buffer of sample pairs, which is then mixed into the
+ * output buffer as a whole.
+ */
+class BufferedRateConverter : public RateConverter {
+protected:
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	/**
+	 * Resample the input into the buffer.
+	 *
+	 * @return Number of sample pairs written into the buffer.
+	 */
+	virtual st_size_t convert(AudioStream &input, st_sample_t *obuf, st_size_t osamp) = 0;
+
+public:
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+		return ST_SUCCESS;
+	}
+};
+
+int BufferedRateConverter::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_size_t done = 0;
+
+	while (done < osamp) {
+		const st_size_t count = MIN<st_size_t>(osamp - done, ARRAYSIZE(outBuf) / 2);
+		const st_size_t converted = convert(input, outBuf, count);
+
+		mixStereo(obuf + done * 2, outBuf, converted, vol_l, vol_r);
+		done += converted;
+
+		// Out of input data
+		if (converted < count)
+			break;
+	}
+
+	return done;
+}
+
 /**
  * Audio rate converter based on simple resampling. Used when no
  * interpolation is required.
@@ -66,7 +200,7 @@ enum {
  * Limited to sampling frequency <= 65535 Hz.
  */
 template<bool stereo>
-class SimpleRateConverter : public RateConverter {
+class SimpleRateConverter : public BufferedRateConverter {
 protected:
 	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
 	const st_sample_t *inPtr;
@@ -79,12 +213,10 @@ protected:
 	/** fractional position increment in the output stream */
 	long opos_inc;
 
+	st_size_t convert(AudioStream &input, st_sample_t *obuf, st_size_t osamp);
+
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
-	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
-		return ST_SUCCESS;
-	}
 };
 
 
@@ -114,7 +246,7 @@ SimpleRateConverter<stereo>::SimpleRateConverter(st_rate_t inrate, st_rate_t out
  * Return number of sample pairs processed.
  */
 template<bool stereo>
-int SimpleRateConverter<stereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+st_size_t SimpleRateConverter<stereo>::convert(AudioStream &input, st_sample_t *obuf, st_size_t osamp) {
 	st_sample_t *ostart, *oend;
 
 	ostart = obuf;
@@ -145,11 +277,8 @@ int SimpleRateConverter<stereo>::flow(AudioStream &input, st_sample_t *obuf, st_
 		// Increment output position
 		opos += opos_inc;
 
-		// output left channel
-		clampedAdd(obuf[0], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-		// output right channel
-		clampedAdd(obuf[1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+		obuf[0] = out0;
+		obuf[1] = out1;
 
 		obuf += 2;
 	}
@@ -168,7 +297,7 @@ int SimpleRateConverter<stereo>::flow(AudioStream &input, st_sample_t *obuf, st_
  */
 
 template<bool stereo>
-class LinearRateConverter : public RateConverter {
+class LinearRateConverter : public BufferedRateConverter {
 protected:
 	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
 	const st_sample_t *inPtr;
@@ -185,12 +314,10 @@ protected:
 	/** current sample(s) in the input stream (left/right channel) */
 	st_sample_t icur0, icur1;
 
+	st_size_t convert(AudioStream &input, st_sample_t *obuf, st_size_t osamp);
+
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
-	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
-		return ST_SUCCESS;
-	}
 };
 
 
@@ -223,7 +350,7 @@ LinearRateConverter<stereo>::LinearRateConverter(st_rate_t inrate, st_rate_t out
  * Return number of sample pairs processed.
  */
 template<bool stereo>
-int LinearRateConverter<stereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+st_size_t LinearRateConverter<stereo>::convert(AudioStream &input, st_sample_t *obuf, st_size_t osamp) {
 	st_sample_t *ostart, *oend;
 
 	ostart = obuf;
@@ -260,11 +387,8 @@ int LinearRateConverter<stereo>::flow(AudioStream &input, st_sample_t *obuf, st_
 						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF_LOW) >> FRAC_BITS_LOW)) :
 						  out0);
 
-			// output left channel
-			clampedAdd(obuf[0], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			obuf[0] = out0;
+			obuf[1] = out1;
 
 			obuf += 2;
 
@@ -279,6 +403,255 @@ int LinearRateConverter<stereo>::flow(AudioStream &input, st_sample_t *obuf, st_
 #pragma mark -
 
 
+#ifdef USE_SSE2_MIXING
+
+/** Multiply and accumulate count (a multiple of 8) samples and coefficients. */
+static inline int dotProduct(const st_sample_t *samples, const int16 *coeffs, uint count) {
+	__m128i acc = _mm_setzero_si128();
+
+	for (uint i = 0; i < count; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(samples + i));
+		const __m128i c = _mm_loadu_si128((const __m128i *)(coeffs + i));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(s, c));
+	}
+
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(acc);
+}
+
+#else
+
+/** Multiply and accumulate count samples and coefficients. */
+static inline int dotProduct(const st_sample_t *samples, const int16 *coeffs, uint count) {
+	int acc = 0;
+
+	for (uint i = 0; i < count; i++)
+		acc += samples[i] * coeffs[i];
+
+	return acc;
+}
+
+#endif // USE_SSE2_MIXING
+
+enum {
+	POLYPHASE_PHASE_BITS = 8,
+	POLYPHASE_PHASES = (1 << POLYPHASE_PHASE_BITS),
+	POLYPHASE_MIN_TAPS = 16,
+	POLYPHASE_MAX_TAPS = 64,
+	POLYPHASE_COEFF_BITS = 14,
+	POLYPHASE_HISTORY_SIZE = INTERMEDIATE_BUFFER_SIZE + POLYPHASE_MAX_TAPS
+};
+
+/**
+ * Audio rate converter based on band-limited interpolation with a
+ * polyphase windowed-sinc filter.
+ *
+ * The filter bank is precomputed for POLYPHASE_PHASES fractional positions
+ * between two input samples. When downsampling, the cutoff is lowered and
+ * the filter gets longer, up to POLYPHASE_MAX_TAPS taps.
+ *
+ * Limited to sampling frequency <= 131071 Hz.
+ */
+template<bool stereo>
+class PolyphaseRateConverter : public BufferedRateConverter {
+protected:
+	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	/** Input samples of each channel, kept for the length of the filter */
+	st_sample_t history[stereo ? 2 : 1][POLYPHASE_HISTORY_SIZE];
+	/** Number of samples in the history */
+	uint histLen;
+	/** Position of the current input sample in the history */
+	uint histPos;
+	/** Whether the history was padded with silence after the end of the input */
+	bool flushed;
+
+	/** fractional position of the output stream after the current input sample */
+	frac_t opos;
+
+	/** fractional position increment in the output stream */
+	frac_t opos_inc;
+
+	/** Number of filter taps */
+	uint taps;
+	/** Filter coefficients, taps for each phase */
+	int16 *coeffs;
+
+	bool fillHistory(AudioStream &input);
+
+	st_size_t convert(AudioStream &input, st_sample_t *obuf, st_size_t osamp);
+
+public:
+	PolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate);
+	~PolyphaseRateConverter();
+};
+
+
+/*
+ * Prepare processing.
+ */
+template<bool stereo>
+PolyphaseRateConverter<stereo>::PolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate) {
+	if (inrate >= 131072 || outrate >= 131072) {
+		error("rate effect can only handle rates < 131072");
+	}
+
+	opos = 0;
+	opos_inc = (inrate << FRAC_BITS_LOW) / outrate;
+
+	// Filter out everything above the lower of the two Nyquist frequencies,
+	// leaving some room for the transition band
+	double cutoff = 0.9;
+	taps = POLYPHASE_MIN_TAPS;
+	if (inrate > outrate) {
+		cutoff *= (double)outrate / inrate;
+		taps = MIN<uint>((POLYPHASE_MIN_TAPS * inrate / outrate + 7) & ~7, POLYPHASE_MAX_TAPS);
+	}
+
+	// The filter for phase p is centered p / POLYPHASE_PHASES samples after
+	// the current input sample. It covers the samples from taps / 2 - 1
+	// before to taps / 2 after the current input sample.
+	coeffs = new int16[POLYPHASE_PHASES * taps];
+
+	double *window = new double[taps];
+
+	for (uint p = 0; p < POLYPHASE_PHASES; p++) {
+		const double frac = (double)p / POLYPHASE_PHASES;
+
+		double sum = 0.0;
+		for (uint i = 0; i < taps; i++) {
+			const double x = (double)i - (taps / 2 - 1) - frac;
+
+			// Blackman window
+			const double w = (x + taps / 2) / taps;
+			const double blackman = 0.42 - 0.5 * cos(2 * M_PI * w) + 0.08 * cos(4 * M_PI * w);
+
+			const double sinc = (x == 0.0) ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+
+			window[i] = cutoff * sinc * blackman;
+			sum += window[i];
+		}
+
+		// Normalize to unity gain. The rounding error goes into the largest
+		// coefficient, so that constant signals pass through unchanged.
+		int16 *phase = coeffs + p * taps;
+		int total = 0;
+		uint largest = 0;
+		for (uint i = 0; i < taps; i++) {
+			phase[i] = (int16)floor(window[i] / sum * (1 << POLYPHASE_COEFF_BITS) + 0.5);
+			total += phase[i];
+
+			if (phase[i] > phase[largest])
+				largest = i;
+		}
+
+		phase[largest] += (1 << POLYPHASE_COEFF_BITS) - total;
+	}
+
+	delete[] window;
+
+	// Start out with silence before the first input sample
+	histLen = taps / 2 - 1;
+	histPos = histLen;
+	flushed = false;
+	memset(history, 0, sizeof(history));
+}
+
+template<bool stereo>
+PolyphaseRateConverter<stereo>::~PolyphaseRateConverter() {
+	delete[] coeffs;
+}
+
+/*
+ * Append the next block of input samples to the history. Once the input
+ * has ended, append silence for the filter to run over the last samples.
+ * Return false if there's no more input.
+ */
+template<bool stereo>
+bool PolyphaseRateConverter<stereo>::fillHistory(AudioStream &input) {
+	// Drop the samples that are no longer covered by the filter. When
+	// downsampling by a large factor, that might even be all of them.
+	const uint start = MIN(histPos - (taps / 2 - 1), histLen);
+	if (start > 0) {
+		for (uint c = 0; c < (stereo ? 2 : 1); c++)
+			memmove(history[c], history[c] + start, (histLen - start) * sizeof(st_sample_t));
+
+		histLen -= start;
+		histPos -= start;
+	}
+
+	const uint space = MIN<uint>(POLYPHASE_HISTORY_SIZE - histLen, INTERMEDIATE_BUFFER_SIZE / (stereo ? 2 : 1));
+
+	const int inLen = input.readBuffer(inBuf, space * (stereo ? 2 : 1));
+	if (inLen <= 0) {
+		if (flushed || !input.endOfStream())
+			return false;
+
+		for (uint c = 0; c < (stereo ? 2 : 1); c++)
+			memset(history[c] + histLen, 0, (taps / 2) * sizeof(st_sample_t));
+
+		histLen += taps / 2;
+		flushed = true;
+		return true;
+	}
+
+	const st_sample_t *inPtr = inBuf;
+	for (int i = 0; i < inLen; i += (stereo ? 2 : 1)) {
+		history[0][histLen] = *inPtr++;
+		if (stereo)
+			history[1][histLen] = *inPtr++;
+		histLen++;
+	}
+
+	return true;
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo>
+st_size_t PolyphaseRateConverter<stereo>::convert(AudioStream &input, st_sample_t *obuf, st_size_t osamp) {
+	st_size_t done = 0;
+
+	while (done < osamp) {
+		// Make sure all the samples covered by the filter are there
+		while (histPos + taps / 2 >= histLen) {
+			if (!fillHistory(input))
+				return done;
+		}
+
+		const int16 *phase = coeffs + (opos >> (FRAC_BITS_LOW - POLYPHASE_PHASE_BITS)) * taps;
+		const uint first = histPos - (taps / 2 - 1);
+
+		int out0 = (dotProduct(history[0] + first, phase, taps) + (1 << (POLYPHASE_COEFF_BITS - 1))) >> POLYPHASE_COEFF_BITS;
+		out0 = CLIP<int>(out0, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+
+		int out1 = out0;
+		if (stereo) {
+			out1 = (dotProduct(history[stereo ? 1 : 0] + first, phase, taps) + (1 << (POLYPHASE_COEFF_BITS - 1))) >> POLYPHASE_COEFF_BITS;
+			out1 = CLIP<int>(out1, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+		}
+
+		obuf[0] = out0;
+		obuf[1] = out1;
+		obuf += 2;
+		done++;
+
+		// Increment output position
+		opos += opos_inc;
+		histPos += opos >> FRAC_BITS_LOW;
+		opos &= FRAC_ONE_LOW - 1;
+	}
+
+	return done;
+}
+
+
+#pragma mark -
+
+
 /**
  * Simple audio rate converter for the case that the inrate equals the outrate.
  */
@@ -295,11 +668,6 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
-		st_size_t len;
-
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -314,24 +682,18 @@ public:
 			error("[CopyRateConverter::flow] Cannot allocate memory for temp buffer");
 
 		// Read up to 'osamp' samples into our temporary buffer
-		len = input.readBuffer(_buffer, osamp);
+		int len = input.readBuffer(_buffer, osamp);
+		if (len <= 0)
+			return 0;
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[0], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
+		if (stereo) {
+			mixStereo(obuf, _buffer, len / 2, vol_l, vol_r);
+			return len / 2;
 		}
-		return (obuf - ostart) / 2;
+
+		mixMono(obuf, _buffer, len, vol_l, vol_r);
+		return len;
 	}
 
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
@@ -343,9 +705,11 @@ public:
 #pragma mark -
 
 template<bool stereo>
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
 	if (inrate != outrate) {
-		if ((inrate % outrate) == 0 && (inrate < 65536)) {
+		if (quality == kRateConverterHighQuality) {
+			return new PolyphaseRateConverter<stereo>(inrate, outrate);
+		} else if ((inrate % outrate) == 0 && (inrate < 65536)) {
 			return new SimpleRateConverter<stereo>(inrate, outrate);
 		} else {
 			return new LinearRateConverter<stereo>(inrate, outrate);
@@ -358,11 +722,11 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, RateConverterQuality quality) {
 	if (stereo)
-		return makeRateConverter<true>(inrate, outrate);
+		return makeRateConverter<true>(inrate, outrate, quality);
 
-	return makeRateConverter<false>(inrate, outrate);
+	return makeRateConverter<false>(inrate, outrate, quality);
 }
 
 } // End of namespace Audio
@@ -80,7 +80,15 @@ public:
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo);
+/** The quality of the rate conversion. */
+enum RateConverterQuality {
+	/** Nearest neighbor or linear interpolation. */
+	kRateConverterNormalQuality,
+	/** Band-limited interpolation with a windowed-sinc filter. */
+	kRateConverterHighQuality
+};
+
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, RateConverterQuality quality = kRateConverterNormalQuality);
 
 } // End of namespace Audio
 
@@ -26,6 +26,7 @@
 #include <linux/cdrom.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 
 #include "backends/audiocd/linux/linux-audiocd.h"
 
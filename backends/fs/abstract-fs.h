@@ -159,6 +159,14 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and last modification time of the file referred by
+	 * this node, without opening it. Backends which cannot query this cheaply
+	 * do not need to implement it.
+	 *
+	 * @return true if the information is available, false otherwise.
+	 */
+	virtual bool getFileStats(uint64 &size, uint32 &modificationTime) const { return false; }
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
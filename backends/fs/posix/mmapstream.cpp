@@ -0,0 +1,162 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#if defined(POSIX)
+
+#if !defined(_FILE_OFFSET_BITS)
+// Match the file offsets of StdioStream
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "backends/fs/posix/mmapstream.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdio.h>
+
+MmapStream::MmapStream(void *handle)
+	: StdioStream(handle), _data(0), _size(0), _pos(0), _eos(false) {
+}
+
+MmapStream::~MmapStream() {
+	if (_data)
+		munmap(const_cast<byte *>(_data), _size);
+}
+
+bool MmapStream::map() {
+	if (_data)
+		return true;
+
+	FILE *handle = (FILE *)_handle;
+
+	struct stat st;
+	if (fstat(fileno(handle), &st) != 0 || !S_ISREG(st.st_mode) ||
+	    st.st_size < (off_t)kMinMapSize || (uint64)st.st_size > 0x7FFFFFFF)
+		return false;
+
+	// Carry on from the position stdio is at
+	off_t pos = ftello(handle);
+	if (pos < 0 || (uint64)pos > 0x7FFFFFFF)
+		return false;
+
+	void *data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(handle), 0);
+	if (data == MAP_FAILED)
+		return false;
+
+	_data = (const byte *)data;
+	_size = (uint32)st.st_size;
+	_pos = (uint32)pos;
+	_eos = StdioStream::eos();
+	return true;
+}
+
+bool MmapStream::eos() const {
+	if (!_data)
+		return StdioStream::eos();
+
+	return _eos;
+}
+
+void MmapStream::clearErr() {
+	StdioStream::clearErr();
+	_eos = false;
+}
+
+int64 MmapStream::pos64() const {
+	if (!_data)
+		return StdioStream::pos64();
+
+	return _pos;
+}
+
+int64 MmapStream::size64() const {
+	if (!_data)
+		return StdioStream::size64();
+
+	return _size;
+}
+
+bool MmapStream::seek64(int64 offs, int whence) {
+	if (!_data)
+		return StdioStream::seek64(offs, whence);
+
+	int64 newPos;
+
+	switch (whence) {
+	case SEEK_END:
+		newPos = (int64)_size + offs;
+		break;
+	case SEEK_CUR:
+		newPos = (int64)_pos + offs;
+		break;
+	case SEEK_SET:
+	default:
+		newPos = offs;
+		break;
+	}
+
+	// Like fseek(), allow seeking past the end but not before the start
+	if (newPos < 0 || newPos > 0x7FFFFFFF)
+		return false;
+
+	_pos = (uint32)newPos;
+	_eos = false;
+	return true;
+}
+
+uint32 MmapStream::read(void *dataPtr, uint32 dataSize) {
+	if (!_data)
+		return StdioStream::read(dataPtr, dataSize);
+
+	uint32 avail = (_pos < _size) ? _size - _pos : 0;
+	if (dataSize > avail) {
+		dataSize = avail;
+		_eos = true;
+	}
+
+	memcpy(dataPtr, _data + _pos, dataSize);
+	_pos += dataSize;
+
+	return dataSize;
+}
+
+const byte *MmapStream::borrowData(uint32 dataSize) {
+	if (!map())
+		return 0;
+
+	if (_pos > _size || dataSize > _size - _pos)
+		return 0;
+
+	const byte *ptr = _data + _pos;
+	_pos += dataSize;
+	return ptr;
+}
+
+MmapStream *MmapStream::makeFromPath(const Common::String &path) {
+	FILE *handle = fopen(path.c_str(), "rb");
+	if (!handle)
+		return 0;
+
+	return new MmapStream(handle);
+}
+
+#endif
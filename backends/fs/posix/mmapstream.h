@@ -0,0 +1,76 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_MMAPSTREAM_H
+#define BACKENDS_FS_POSIX_MMAPSTREAM_H
+
+#include "backends/fs/stdiostream.h"
+
+/**
+ * Read-only file stream which maps the file into memory with mmap() once
+ * borrowData() is called, so that it can hand out pointers straight into
+ * the mapping. This suits the small random reads engines do on big resource
+ * bundles.
+ *
+ * Until then, and for files which are too small to be worth mapping or
+ * which mmap() refuses, it reads through stdio like StdioStream. Files are
+ * only mapped on request, as accessing a mapping whose file was truncated
+ * raises SIGBUS.
+ */
+class MmapStream : public StdioStream {
+protected:
+	const byte *_data;
+	uint32 _size;
+	uint32 _pos;
+	bool _eos;
+
+	MmapStream(void *handle);
+
+	/** Map the file, unless it is already mapped. Returns false on failure. */
+	bool map();
+
+public:
+	/**
+	 * Files smaller than this are not mapped: mapping them costs more than
+	 * it saves, so borrowData() returns 0 and callers fall back to read().
+	 */
+	static const uint32 kMinMapSize = 64 * 1024;
+
+	/**
+	 * Given a path, opens the file for reading and wraps it in a MmapStream
+	 * instance. Returns 0 if the file could not be opened.
+	 */
+	static MmapStream *makeFromPath(const Common::String &path);
+
+	virtual ~MmapStream();
+
+	virtual bool eos() const;
+	virtual void clearErr();
+
+	virtual int64 pos64() const;
+	virtual int64 size64() const;
+	virtual bool seek64(int64 offs, int whence = SEEK_SET);
+	virtual uint32 read(void *dataPtr, uint32 dataSize);
+	virtual const byte *borrowData(uint32 dataSize);
+};
+
+#endif
@@ -24,8 +24,16 @@
 
 #if defined(POSIX) || defined(PLAYSTATION3)
 
+#if defined(POSIX) && !defined(_FILE_OFFSET_BITS)
+// Let getFileStats() report the size of files larger than 2 GB on 32-bit systems
+#define _FILE_OFFSET_BITS 64
+#endif
+
 #include "backends/fs/posix/posix-fs.h"
 #include "backends/fs/stdiostream.h"
+#if defined(POSIX)
+#include "backends/fs/posix/mmapstream.h"
+#endif
 #include "common/algorithm.h"
 
 #include <sys/param.h>
@@ -46,6 +54,17 @@ void POSIXFilesystemNode::setFlags() {
 	_isDirectory = _isValid ? S_ISDIR(st.st_mode) : false;
 }
 
+bool POSIXFilesystemNode::getFileStats(uint64 &size, uint32 &modificationTime) const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+
+	size = (uint64)st.st_size;
+	modificationTime = (uint32)st.st_mtime;
+	return true;
+}
+
 POSIXFilesystemNode::POSIXFilesystemNode(const Common::String &p) {
 	assert(p.size() > 0);
 
@@ -238,7 +257,12 @@ AbstractFSNode *POSIXFilesystemNode::getParent() const {
 }
 
 Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
+#if defined(POSIX)
+	// Reads through stdio, but maps the file into memory for borrowData()
+	return MmapStream::makeFromPath(getPath());
+#else
 	return StdioStream::makeFromPath(getPath(), false);
+#endif
 }
 
 Common::WriteStream *POSIXFilesystemNode::createWriteStream() {
@@ -24,8 +24,41 @@
 
 #if !defined(DISABLE_STDIO_FILESTREAM)
 
+#if defined(POSIX) && !defined(_FILE_OFFSET_BITS)
+// Let 32-bit systems open and seek in files larger than 2 GB, too
+#define _FILE_OFFSET_BITS 64
+#endif
+
 #include "backends/fs/stdiostream.h"
 
+#if defined(POSIX)
+#include <sys/types.h>
+#endif
+
+static int64 stdioTell64(FILE *handle) {
+#if defined(POSIX)
+	return ftello(handle);
+#elif defined(_MSC_VER)
+	return _ftelli64(handle);
+#else
+	return ftell(handle);
+#endif
+}
+
+static bool stdioSeek64(FILE *handle, int64 offs, int whence) {
+#if defined(POSIX)
+	if ((off_t)offs != offs)
+		return false;
+	return fseeko(handle, (off_t)offs, whence) == 0;
+#elif defined(_MSC_VER)
+	return _fseeki64(handle, offs, whence) == 0;
+#else
+	if ((long)offs != offs)
+		return false;
+	return fseek(handle, (long)offs, whence) == 0;
+#endif
+}
+
 StdioStream::StdioStream(void *handle) : _handle(handle) {
 	assert(handle);
 }
@@ -47,20 +80,32 @@ bool StdioStream::eos() const {
 }
 
 int32 StdioStream::pos() const {
-	return ftell((FILE *)_handle);
+	return narrowTo32(pos64());
 }
 
 int32 StdioStream::size() const {
-	int32 oldPos = ftell((FILE *)_handle);
-	fseek((FILE *)_handle, 0, SEEK_END);
-	int32 length = ftell((FILE *)_handle);
-	fseek((FILE *)_handle, oldPos, SEEK_SET);
+	return narrowTo32(size64());
+}
+
+bool StdioStream::seek(int32 offs, int whence) {
+	return seek64(offs, whence);
+}
+
+int64 StdioStream::pos64() const {
+	return stdioTell64((FILE *)_handle);
+}
+
+int64 StdioStream::size64() const {
+	int64 oldPos = stdioTell64((FILE *)_handle);
+	stdioSeek64((FILE *)_handle, 0, SEEK_END);
+	int64 length = stdioTell64((FILE *)_handle);
+	stdioSeek64((FILE *)_handle, oldPos, SEEK_SET);
 
 	return length;
 }
 
-bool StdioStream::seek(int32 offs, int whence) {
-	return fseek((FILE *)_handle, offs, whence) == 0;
+bool StdioStream::seek64(int64 offs, int whence) {
+	return stdioSeek64((FILE *)_handle, offs, whence);
 }
 
 uint32 StdioStream::read(void *ptr, uint32 len) {
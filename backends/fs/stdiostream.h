@@ -53,6 +53,9 @@ public:
 	virtual int32 pos() const;
 	virtual int32 size() const;
 	virtual bool seek(int32 offs, int whence = SEEK_SET);
+	virtual int64 pos64() const;
+	virtual int64 size64() const;
+	virtual bool seek64(int64 offs, int whence = SEEK_SET);
 	virtual uint32 read(void *dataPtr, uint32 dataSize);
 };
 
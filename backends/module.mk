@@ -117,6 +117,7 @@ endif
 
 ifdef POSIX
 MODULE_OBJS += \
+	fs/posix/mmapstream.o \
 	fs/posix/posix-fs.o \
 	fs/posix/posix-fs-factory.o \
 	plugins/posix/posix-provider.o \
@@ -24,9 +24,17 @@
 
 #include "common/scummsys.h"
 #include "backends/timer/default/default-timer.h"
+#include "common/debug.h"
 #include "common/util.h"
 #include "common/system.h"
 
+enum {
+	// When a timer falls further behind than this (in milliseconds), e.g.
+	// because the process was suspended, the missed invocations are dropped
+	// rather than run back to back.
+	kMaxTimerLag = 500
+};
+
 struct TimerSlot {
 	Common::TimerManager::TimerProc callback;
 	void *refCon;
@@ -36,48 +44,70 @@ struct TimerSlot {
 	uint32 nextFireTime;	// in milliseconds
 	uint32 nextFireTimeMicro;	// microseconds part of nextFire
 
-	TimerSlot *next;
+	DefaultTimerManager::TimerStats stats;
 };
 
-void insertPrioQueue(TimerSlot *head, TimerSlot *newSlot) {
-	// The head points to a fake anchor TimerSlot; this common
-	// trick allows us to get rid of many special cases.
+static bool firesBefore(const TimerSlot *a, const TimerSlot *b) {
+	// Compare the difference, so that this works across the wrap around
+	// of getMillis()
+	if (a->nextFireTime != b->nextFireTime)
+		return (int32)(a->nextFireTime - b->nextFireTime) < 0;
+	return a->nextFireTimeMicro < b->nextFireTimeMicro;
+}
+
+static void siftUp(Common::Array<TimerSlot *> &queue, uint pos) {
+	TimerSlot *slot = queue[pos];
+
+	while (pos > 0) {
+		uint parent = (pos - 1) / 2;
+		if (!firesBefore(slot, queue[parent]))
+			break;
+		queue[pos] = queue[parent];
+		pos = parent;
+	}
+
+	queue[pos] = slot;
+}
 
-	const uint32 nextFireTime = newSlot->nextFireTime;
-	TimerSlot *slot = head;
-	newSlot->next = 0;
+static void siftDown(Common::Array<TimerSlot *> &queue, uint pos) {
+	TimerSlot *slot = queue[pos];
+	const uint size = queue.size();
 
-	// Insert the new slot into the sorted list of already scheduled
-	// timers in such a way that the list stays sorted...
 	while (true) {
-		assert(slot);
-		if (slot->next == 0 || nextFireTime < slot->next->nextFireTime) {
-			newSlot->next = slot->next;
-			slot->next = newSlot;
-			return;
-		}
-		slot = slot->next;
+		uint child = pos * 2 + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && firesBefore(queue[child + 1], queue[child]))
+			child++;
+		if (!firesBefore(queue[child], slot))
+			break;
+		queue[pos] = queue[child];
+		pos = child;
 	}
+
+	queue[pos] = slot;
 }
 
+static void advanceFireTime(TimerSlot *slot) {
+	slot->nextFireTime += (slot->interval / 1000);
+	slot->nextFireTimeMicro += (slot->interval % 1000);
+	if (slot->nextFireTimeMicro >= 1000) {
+		slot->nextFireTime += slot->nextFireTimeMicro / 1000;
+		slot->nextFireTimeMicro %= 1000;
+	}
+}
 
-DefaultTimerManager::DefaultTimerManager() :
-	_head(0) {
 
-	_head = new TimerSlot();
-	memset(_head, 0, sizeof(TimerSlot));
+DefaultTimerManager::DefaultTimerManager() :
+	_runningSlot(0) {
 }
 
 DefaultTimerManager::~DefaultTimerManager() {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
-	while (slot) {
-		TimerSlot *next = slot->next;
-		delete slot;
-		slot = next;
-	}
-	_head = 0;
+	for (uint i = 0; i < _queue.size(); i++)
+		delete _queue[i];
+	_queue.clear();
 }
 
 void DefaultTimerManager::handler() {
@@ -86,28 +116,46 @@ void DefaultTimerManager::handler() {
 	uint32 curTime = g_system->getMillis();
 
 	// Repeat as long as there is a TimerSlot that is scheduled to fire.
-	TimerSlot *slot = _head->next;
-	while (slot && slot->nextFireTime < curTime) {
-		// Remove the slot from the priority queue
-		_head->next = slot->next;
+	while (!_queue.empty()) {
+		TimerSlot *slot = _queue[0];
+		int32 lag = (int32)(curTime - slot->nextFireTime);
+		if (lag <= 0)
+			break;
+
+		TimerStats &stats = slot->stats;
+		uint32 lateness = (uint32)lag * 1000 - slot->nextFireTimeMicro;
 
-		// Update the fire time and reinsert the TimerSlot into the priority
-		// queue.
+		// Update the fire time and move the TimerSlot to its new place in the
+		// priority queue.
 		assert(slot->interval > 0);
-		slot->nextFireTime += (slot->interval / 1000);
-		slot->nextFireTimeMicro += (slot->interval % 1000);
-		if (slot->nextFireTimeMicro > 1000) {
-			slot->nextFireTime += slot->nextFireTimeMicro / 1000;
-			slot->nextFireTimeMicro %= 1000;
+		if (lag > kMaxTimerLag) {
+			stats.overrunCount += (uint32)((lag * 1000.0) / slot->interval);
+			slot->nextFireTime = curTime;
+			slot->nextFireTimeMicro = 0;
+			// The skipped invocations are counted as overruns instead
+			lateness = kMaxTimerLag * 1000;
 		}
-		insertPrioQueue(_head, slot);
+		advanceFireTime(slot);
+		siftDown(_queue, 0);
+
+		stats.fireCount++;
+		stats.maxLateness = MAX(stats.maxLateness, lateness);
+		// Keep a moving average, so that it reflects the recent behavior
+		stats.avgLateness = (int32)stats.avgLateness + ((int32)lateness - (int32)stats.avgLateness) / 16;
 
 		// Invoke the timer callback
 		assert(slot->callback);
+		uint32 startTime = g_system->getMillis();
+		_runningSlot = slot;
 		slot->callback(slot->refCon);
+		uint32 duration = g_system->getMillis() - startTime;
 
-		// Look at the next scheduled timer
-		slot = _head->next;
+		// The callback may have removed its own timer
+		if (_runningSlot) {
+			stats.maxDuration = MAX(stats.maxDuration, duration);
+			stats.totalDuration += duration;
+			_runningSlot = 0;
+		}
 	}
 }
 
@@ -136,9 +184,10 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 	slot->interval = interval;
 	slot->nextFireTime = g_system->getMillis() + interval / 1000;
 	slot->nextFireTimeMicro = interval % 1000;
-	slot->next = 0;
+	memset(&slot->stats, 0, sizeof(slot->stats));
 
-	insertPrioQueue(_head, slot);
+	_queue.push_back(slot);
+	siftUp(_queue, _queue.size() - 1);
 
 	return true;
 }
@@ -146,18 +195,29 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
+	uint count = 0;
 
-	while (slot->next) {
-		if (slot->next->callback == callback) {
-			TimerSlot *next = slot->next->next;
-			delete slot->next;
-			slot->next = next;
+	for (uint i = 0; i < _queue.size(); i++) {
+		TimerSlot *slot = _queue[i];
+
+		if (slot->callback == callback) {
+			const TimerStats &stats = slot->stats;
+			debug(2, "Timer '%s' removed: fired %d times, lateness avg %d us max %d us, %d overruns, callback time total %d ms max %d ms",
+			      slot->id.c_str(), stats.fireCount, stats.avgLateness, stats.maxLateness,
+			      stats.overrunCount, stats.totalDuration, stats.maxDuration);
+			if (slot == _runningSlot)
+				_runningSlot = 0;
+			delete slot;
 		} else {
-			slot = slot->next;
+			_queue[count++] = slot;
 		}
 	}
 
+	// Restore the heap order over what is left
+	_queue.resize(count);
+	for (uint i = count / 2; i-- > 0; )
+		siftDown(_queue, i);
+
 	// We need to remove all names referencing the timer proc here.
 	//
 	// Else we run into troubles, when the client code removes and readds timer
@@ -175,3 +235,16 @@ void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 			_callbacks.erase(i);
 	}
 }
+
+bool DefaultTimerManager::getTimerStats(const Common::String &id, TimerStats &stats) {
+	Common::StackLock lock(_mutex);
+
+	for (uint i = 0; i < _queue.size(); i++) {
+		if (_queue[i]->id.equalsIgnoreCase(id)) {
+			stats = _queue[i]->stats;
+			return true;
+		}
+	}
+
+	return false;
+}
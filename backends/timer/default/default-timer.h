@@ -23,6 +23,7 @@
 #ifndef BACKENDS_TIMER_DEFAULT_H
 #define BACKENDS_TIMER_DEFAULT_H
 
+#include "common/array.h"
 #include "common/str.h"
 #include "common/hash-str.h"
 #include "common/timer.h"
@@ -31,12 +32,26 @@
 struct TimerSlot;
 
 class DefaultTimerManager : public Common::TimerManager {
+public:
+	/**
+	 * Statistics gathered for each installed timer.
+	 */
+	struct TimerStats {
+		uint32 fireCount;		///< number of times the callback was invoked
+		uint32 maxLateness;		///< largest delay between deadline and invocation, in microseconds
+		uint32 avgLateness;		///< average delay between deadline and invocation, in microseconds
+		uint32 overrunCount;	///< number of invocations skipped because the timer fell too far behind
+		uint32 maxDuration;		///< longest callback run time, in milliseconds
+		uint32 totalDuration;	///< total callback run time, in milliseconds
+	};
+
 private:
 	typedef Common::HashMap<Common::String, TimerProc, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> TimerSlotMap;
 
 	Common::Mutex _mutex;
-	TimerSlot *_head;
+	Common::Array<TimerSlot *> _queue;	///< binary heap, ordered by deadline
 	TimerSlotMap _callbacks;
+	TimerSlot *_runningSlot;	///< the timer whose callback is being invoked
 
 public:
 	DefaultTimerManager();
@@ -44,6 +59,13 @@ public:
 	virtual bool installTimerProc(TimerProc proc, int32 interval, void *refCon, const Common::String &id);
 	virtual void removeTimerProc(TimerProc proc);
 
+	/**
+	 * Retrieve the statistics of the timer installed with the given id.
+	 *
+	 * @return true if such a timer is installed, false otherwise
+	 */
+	bool getTimerStats(const Common::String &id, TimerStats &stats);
+
 	/**
 	 * Timer callback, to be invoked at regular time intervals by the backend.
 	 */
@@ -28,6 +28,8 @@
 #include "common/debug.h"
 #include "common/config-manager.h"
 
+#include "engines/advancedDetector.h"
+
 #ifdef DYNAMIC_MODULES
 #include "common/fs.h"
 #endif
@@ -513,7 +515,7 @@ GameDescriptor EngineManager::findGameInLoadedPlugins(const Common::String &game
 	return result;
 }
 
-GameList EngineManager::detectGames(const Common::FSList &fslist) const {
+GameList EngineManager::detectGames(const Common::FSList &fslist, bool flushCache) const {
 	GameList candidates;
 	EnginePlugin::List plugins;
 	EnginePlugin::List::const_iterator iter;
@@ -526,9 +528,16 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 			candidates.push_back((**iter)->detectGames(fslist));
 		}
 	} while (PluginManager::instance().loadNextPlugin());
+
+	if (flushCache)
+		flushDetectionCache();
 	return candidates;
 }
 
+void EngineManager::flushDetectionCache() const {
+	AdvancedMetaEngine::flushDetectionCache();
+}
+
 const EnginePlugin::List &EngineManager::getPlugins() const {
 	return (const EnginePlugin::List &)PluginManager::instance().getPlugins(PLUGIN_TYPE_ENGINE);
 }
@@ -28,6 +28,8 @@
 #include "common/scummsys.h"
 #include "common/textconsole.h"
 #include "common/stream.h"
+#include "common/endian.h"
+#include "common/util.h"
 
 namespace Common {
 
@@ -70,6 +72,9 @@ public:
 	/** Add a bit to the value x, making it an n+1-bit value. */
 	virtual void addBit(uint32 &x, uint32 n) = 0;
 
+	/** Are the bits handed out in the order of MSB to LSB? */
+	virtual bool isMSBFirst() const = 0;
+
 protected:
 	BitStream() {
 	}
@@ -265,6 +270,11 @@ public:
 			x = (x & ~(1 << n)) | (getBit() << n);
 	}
 
+	/** Are the bits handed out in the order of MSB to LSB? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
 	/** Rewind the bit stream back to the start. */
 	void rewind() {
 		_stream->seek(0);
@@ -275,6 +285,22 @@ public:
 
 	/** Skip the specified amount of bits. */
 	void skip(uint32 n) {
+		// Finish the current value
+		while ((n > 0) && (_inValue != 0)) {
+			getBit();
+			n--;
+		}
+
+		// Skip over whole values directly in the data stream
+		const uint32 values = n / valueBits;
+		if (values > 0) {
+			if ((size() - pos()) < (values * valueBits))
+				error("BitStreamImpl::skip(): End of bit stream reached");
+
+			_stream->seek(values * (valueBits >> 3), SEEK_CUR);
+			n -= values * valueBits;
+		}
+
 		while (n-- > 0)
 			getBit();
 	}
@@ -304,6 +330,277 @@ public:
 	}
 };
 
+#ifdef HAVE_INT64
+
+/**
+ * A template implementing a bit stream with a 64-bit read cache.
+ *
+ * It hands out exactly the same bits as a BitStreamImpl with the same
+ * layout parameters, but it reads as many data values as fit into a
+ * 64-bit cache at once. Multi-bit reads, peeks and skips are then done
+ * with a few shifts, instead of bit by bit.
+ *
+ * Since data is read ahead, the position of the data stream doesn't
+ * match the position of the bit stream. The data stream should not be
+ * accessed directly while the bit stream is in use.
+ */
+template<int valueBits, bool isLE, bool isMSB2LSB>
+class BitStreamCachedImpl : public BitStream {
+private:
+	SeekableReadStream *_stream; ///< The input stream.
+	bool _disposeAfterUse;       ///< Should we delete the stream on destruction?
+
+	uint32 _size;    ///< Size of the stream in bits.
+	uint32 _readPos; ///< Position of the next data value in the stream.
+
+	/**
+	 * The cached bits, read from the data stream but not yet handed out.
+	 *
+	 * The next bit is the MSB if we're reading MSB first, the LSB otherwise.
+	 */
+	uint64 _cache;
+	uint8  _inCache; ///< Number of bits in the cache.
+
+	/** Read a data value out of the buffer. */
+	inline uint32 readData(const byte *data) {
+		if (isLE) {
+			if (valueBits ==  8)
+				return *data;
+			if (valueBits == 16)
+				return READ_LE_UINT16(data);
+			if (valueBits == 32)
+				return READ_LE_UINT32(data);
+		} else {
+			if (valueBits ==  8)
+				return *data;
+			if (valueBits == 16)
+				return READ_BE_UINT16(data);
+			if (valueBits == 32)
+				return READ_BE_UINT32(data);
+		}
+
+		assert(false);
+		return 0;
+	}
+
+	/** Fill the cache with as many data values as fit. */
+	inline void refill() {
+		const uint32 valueBytes = valueBits >> 3;
+
+		uint32 count = ((64 - _inCache) / valueBits) * valueBytes;
+		if (_readPos + count > (_size >> 3))
+			count = (_size >> 3) - MIN(_readPos, _size >> 3);
+
+		count -= count % valueBytes;
+		if (count == 0)
+			return;
+
+		byte data[8];
+		if (_stream->read(data, count) != count)
+			error("BitStreamCachedImpl::refill(): Read error");
+
+		_readPos += count;
+
+		for (uint32 i = 0; i < count; i += valueBytes) {
+			const uint64 value = readData(data + i);
+
+			if (isMSB2LSB)
+				_cache |= value << (64 - valueBits - _inCache);
+			else
+				_cache |= value << _inCache;
+
+			_inCache += valueBits;
+		}
+	}
+
+	/** Make sure at least n bits are in the cache. */
+	inline void fill(uint8 n) {
+		if (_inCache >= n)
+			return;
+
+		refill();
+		if (_inCache < n)
+			error("BitStreamCachedImpl::fill(): End of bit stream reached");
+	}
+
+	/** Remove n cached bits. */
+	inline void consume(uint8 n) {
+		if (n >= 64)
+			_cache = 0;
+		else if (isMSB2LSB)
+			_cache <<= n;
+		else
+			_cache >>= n;
+
+		_inCache -= n;
+	}
+
+	/** Return the next n (1 - 32) cached bits. */
+	inline uint32 cached(uint8 n) const {
+		if (isMSB2LSB)
+			return (uint32)(_cache >> (64 - n));
+
+		return (uint32)(_cache & ((((uint64)1) << n) - 1));
+	}
+
+	void init() {
+		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
+			error("BitStreamCachedImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+
+		_size    = (_stream->size() & ~((uint32) ((valueBits >> 3) - 1))) * 8;
+		_readPos = _stream->pos();
+	}
+
+public:
+	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
+	BitStreamCachedImpl(SeekableReadStream *stream, bool disposeAfterUse = false) :
+		_stream(stream), _disposeAfterUse(disposeAfterUse), _size(0), _readPos(0), _cache(0), _inCache(0) {
+
+		init();
+	}
+
+	/** Create a bit stream using this input data stream. */
+	BitStreamCachedImpl(SeekableReadStream &stream) :
+		_stream(&stream), _disposeAfterUse(false), _size(0), _readPos(0), _cache(0), _inCache(0) {
+
+		init();
+	}
+
+	~BitStreamCachedImpl() {
+		if (_disposeAfterUse)
+			delete _stream;
+	}
+
+	/** Read a bit from the bit stream. */
+	uint32 getBit() {
+		fill(1);
+
+		const uint32 b = cached(1);
+		consume(1);
+
+		return b;
+	}
+
+	/**
+	 * Read a multi-bit value from the bit stream.
+	 *
+	 * The bit order is the same as in BitStreamImpl::getBits().
+	 */
+	uint32 getBits(uint8 n) {
+		if (n == 0)
+			return 0;
+
+		if (n > 32)
+			error("BitStreamCachedImpl::getBits(): Too many bits requested to be read");
+
+		fill(n);
+
+		const uint32 v = cached(n);
+		consume(n);
+
+		return v;
+	}
+
+	/** Read a bit from the bit stream, without changing the stream's position. */
+	uint32 peekBit() {
+		fill(1);
+
+		return cached(1);
+	}
+
+	/**
+	 * Read a multi-bit value from the bit stream, without changing the stream's position.
+	 *
+	 * The bit order is the same as in getBits().
+	 */
+	uint32 peekBits(uint8 n) {
+		if (n == 0)
+			return 0;
+
+		if (n > 32)
+			error("BitStreamCachedImpl::peekBits(): Too many bits requested to be read");
+
+		fill(n);
+
+		return cached(n);
+	}
+
+	/**
+	 * Add a bit to the value x, making it an n+1-bit value.
+	 *
+	 * See BitStreamImpl::addBit() for the resulting bit order.
+	 */
+	void addBit(uint32 &x, uint32 n) {
+		if (n >= 32)
+			error("BitStreamCachedImpl::addBit(): Too many bits requested to be read");
+
+		if (isMSB2LSB)
+			x = (x << 1) | getBit();
+		else
+			x = (x & ~(1 << n)) | (getBit() << n);
+	}
+
+	/** Are the bits handed out in the order of MSB to LSB? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
+	/** Rewind the bit stream back to the start. */
+	void rewind() {
+		_stream->seek(0);
+
+		_readPos = 0;
+		_cache   = 0;
+		_inCache = 0;
+	}
+
+	/** Skip the specified amount of bits. */
+	void skip(uint32 n) {
+		if (n > _inCache) {
+			n -= _inCache;
+
+			_cache   = 0;
+			_inCache = 0;
+
+			// Skip over whole values directly in the data stream
+			const uint32 values = n / valueBits;
+			if (values > 0) {
+				if ((_readPos * 8 + values * valueBits) > _size)
+					error("BitStreamCachedImpl::skip(): End of bit stream reached");
+
+				_stream->seek(values * (valueBits >> 3), SEEK_CUR);
+				_readPos += values * (valueBits >> 3);
+				n -= values * valueBits;
+			}
+
+			fill(n);
+		}
+
+		consume(n);
+	}
+
+	/** Skip the bits to closest data value border. */
+	void align() {
+		skip((valueBits - (pos() % valueBits)) % valueBits);
+	}
+
+	/** Return the stream position in bits. */
+	uint32 pos() const {
+		return _readPos * 8 - _inCache;
+	}
+
+	/** Return the stream size in bits. */
+	uint32 size() const {
+		return _size;
+	}
+
+	bool eos() const {
+		return pos() >= size();
+	}
+};
+
+#endif // HAVE_INT64
+
 // typedefs for various memory layouts.
 
 /** 8-bit data, MSB to LSB. */
@@ -329,6 +626,33 @@ typedef BitStreamImpl<32, false, true > BitStream32BEMSB;
 /** 32-bit big-endian data, LSB to MSB. */
 typedef BitStreamImpl<32, false, false> BitStream32BELSB;
 
+#ifdef HAVE_INT64
+
+/** 8-bit data, MSB to LSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<8, false, true > BitStreamCached8MSB;
+/** 8-bit data, LSB to MSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<8, false, false> BitStreamCached8LSB;
+
+/** 16-bit little-endian data, MSB to LSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<16, true , true > BitStreamCached16LEMSB;
+/** 16-bit little-endian data, LSB to MSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<16, true , false> BitStreamCached16LELSB;
+/** 16-bit big-endian data, MSB to LSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<16, false, true > BitStreamCached16BEMSB;
+/** 16-bit big-endian data, LSB to MSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<16, false, false> BitStreamCached16BELSB;
+
+/** 32-bit little-endian data, MSB to LSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<32, true , true > BitStreamCached32LEMSB;
+/** 32-bit little-endian data, LSB to MSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<32, true , false> BitStreamCached32LELSB;
+/** 32-bit big-endian data, MSB to LSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<32, false, true > BitStreamCached32BEMSB;
+/** 32-bit big-endian data, LSB to MSB, read through a 64-bit cache. */
+typedef BitStreamCachedImpl<32, false, false> BitStreamCached32BELSB;
+
+#endif // HAVE_INT64
+
 } // End of namespace Common
 
 #endif // COMMON_BITSTREAM_H
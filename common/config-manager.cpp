@@ -110,6 +110,14 @@ void ConfigManager::loadConfigFile(const String &filename) {
 	}
 }
 
+String ConfigManager::getConfigFileName() const {
+	if (!_filename.empty())
+		return _filename;
+
+	assert(g_system);
+	return g_system->getDefaultConfigFileName();
+}
+
 /**
  * Add a ready-made domain based on its name and contents
  * The domain name should not already exist in the ConfigManager.
@@ -97,6 +97,12 @@ public:
 	void				loadDefaultConfigFile();
 	void				loadConfigFile(const String &filename);
 
+	/**
+	 * Return the name of the config file in use: the one passed to
+	 * loadConfigFile(), or the backend's default config file.
+	 */
+	String				getConfigFileName() const;
+
 	/**
 	 * Retrieve the config domain with the given name.
 	 * @param domName	the name of the domain to retrieve
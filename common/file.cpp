@@ -136,11 +136,40 @@ bool File::seek(int32 offs, int whence) {
 	return _handle->seek(offs, whence);
 }
 
+// The 64-bit methods go through the virtual 32-bit ones whenever the value
+// fits, so that subclasses which remap pos(), size() and seek() (such as
+// files embedded at an offset in a container) keep working when they are
+// accessed through the 64-bit API, e.g. by a SeekableSubReadStream.
+
+int64 File::pos64() const {
+	assert(_handle);
+	int32 pos32 = pos();
+	return (pos32 >= 0) ? pos32 : _handle->pos64();
+}
+
+int64 File::size64() const {
+	assert(_handle);
+	int32 size32 = size();
+	return (size32 >= 0) ? size32 : _handle->size64();
+}
+
+bool File::seek64(int64 offs, int whence) {
+	assert(_handle);
+	if (offs >= -0x7FFFFFFF - 1 && offs <= 0x7FFFFFFF)
+		return seek((int32)offs, whence);
+	return _handle->seek64(offs, whence);
+}
+
 uint32 File::read(void *ptr, uint32 len) {
 	assert(_handle);
 	return _handle->read(ptr, len);
 }
 
+const byte *File::borrowData(uint32 dataSize) {
+	assert(_handle);
+	return _handle->borrowData(dataSize);
+}
+
 
 DumpFile::DumpFile() : _handle(0) {
 }
@@ -125,6 +125,11 @@ public:
 	int32 size() const;	// implement abstract SeekableReadStream method
 	bool seek(int32 offs, int whence = SEEK_SET);	// implement abstract SeekableReadStream method
 	uint32 read(void *dataPtr, uint32 dataSize);	// implement abstract SeekableReadStream method
+
+	int64 pos64() const;	// uses pos() when it fits, so subclasses overriding it are honored
+	int64 size64() const;	// uses size() when it fits, so subclasses overriding it are honored
+	bool seek64(int64 offs, int whence = SEEK_SET);	// uses seek() when it fits, so subclasses overriding it are honored
+	const byte *borrowData(uint32 dataSize);	// forwarded to the underlying stream
 };
 
 
@@ -206,6 +206,18 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieves the size and last modification time of the file referred by
+	 * this node, without opening it. Not all backends support this, callers
+	 * must not rely on it being available.
+	 *
+	 * @param size				the size of the file in bytes
+	 * @param modificationTime	the time of the last modification, in a
+	 *							backend specific unit
+	 * @return true if the information is available, false otherwise.
+	 */
+	bool getFileStats(uint64 &size, uint32 &modificationTime) const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
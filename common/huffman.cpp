@@ -45,6 +45,8 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 
 	assert(maxLength <= 32);
 
+	_tableBits = MIN<uint8>(maxLength, kTableBits);
+
 	_codes.resize(maxLength);
 	_symbols.resize(codeCount);
 
@@ -58,6 +60,8 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 		// And put the pointer to the symbol/code struct into the symbol list.
 		_symbols[i] = &_codes[lengths[i] - 1].back();
 	}
+
+	buildTables();
 }
 
 Huffman::~Huffman() {
@@ -66,9 +70,120 @@ Huffman::~Huffman() {
 void Huffman::setSymbols(const uint32 *symbols) {
 	for (uint32 i = 0; i < _symbols.size(); i++)
 		_symbols[i]->symbol = symbols ? *symbols++ : i;
+
+	buildTables();
+}
+
+void Huffman::buildTables() {
+	buildTable(_tableMSB, true);
+	buildTable(_tableLSB, false);
+}
+
+void Huffman::buildTable(LookupTable &table, bool msb2lsb) {
+	table.clear();
+	table.resize(1 << _tableBits);
+
+	const uint32 prefixMask = (1 << _tableBits) - 1;
+
+	// Codes fitting into the first level. Shorter codes are added first,
+	// so that they take precedence, like in the bit-by-bit search
+	for (uint32 i = 0; i < _codes.size() && i < _tableBits; i++)
+		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
+			fillTable(table, 0, _tableBits, cCode->code, i + 1, cCode->symbol, i + 1, msb2lsb);
+
+	// Find the size of the second-level table needed for each prefix of the longer codes
+	for (uint32 i = _tableBits; i < _codes.size(); i++) {
+		const uint8 length = i + 1;
+
+		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode) {
+			const uint32 prefix = msb2lsb ? (cCode->code >> (length - _tableBits)) : (cCode->code & prefixMask);
+
+			TableEntry &entry = table[prefix];
+			if (entry.length != 0)
+				continue;
+
+			// Overly long codes are left to the bit-by-bit search
+			entry.subBits = MAX<uint8>(entry.subBits, MIN<uint8>(length - _tableBits, _tableBits));
+		}
+	}
+
+	// Allocate the second-level tables
+	for (uint32 prefix = 0; prefix <= prefixMask; prefix++) {
+		if (table[prefix].subBits == 0)
+			continue;
+
+		table[prefix].symbol = table.size();
+		table.resize(table.size() + (1 << table[prefix].subBits));
+	}
+
+	// And fill them
+	for (uint32 i = _tableBits; i < _codes.size(); i++) {
+		const uint8 length = i + 1;
+		const uint8 restLength = length - _tableBits;
+
+		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode) {
+			const uint32 prefix = msb2lsb ? (cCode->code >> restLength) : (cCode->code & prefixMask);
+
+			const TableEntry entry = table[prefix];
+			if (entry.length != 0 || restLength > entry.subBits)
+				continue;
+
+			const uint32 rest = msb2lsb ? (cCode->code & ((1 << restLength) - 1)) : (cCode->code >> _tableBits);
+
+			fillTable(table, entry.symbol, entry.subBits, rest, restLength, cCode->symbol, length, msb2lsb);
+		}
+	}
+}
+
+void Huffman::fillTable(LookupTable &table, uint32 offset, uint8 tableBits, uint32 code, uint8 length,
+                        uint32 symbol, uint8 fullLength, bool msb2lsb) {
+
+	// Every index starting with the code resolves to it
+	const uint32 count = 1 << (tableBits - length);
+
+	for (uint32 i = 0; i < count; i++) {
+		const uint32 index = msb2lsb ? ((code << (tableBits - length)) | i) : (code | (i << length));
+
+		TableEntry &entry = table[offset + index];
+		if (entry.length != 0 || entry.subBits != 0)
+			continue;
+
+		entry.symbol = symbol;
+		entry.length = fullLength;
+	}
 }
 
 uint32 Huffman::getSymbol(BitStream &bits) const {
+	const bool msb2lsb = bits.isMSBFirst();
+	const LookupTable &table = msb2lsb ? _tableMSB : _tableLSB;
+
+	// Near the end of the stream, there might not be enough bits left to peek at
+	const uint32 bitsLeft = bits.size() - bits.pos();
+
+	if (bitsLeft >= _tableBits) {
+		const TableEntry *entry = &table[bits.peekBits(_tableBits)];
+
+		if (entry->subBits != 0) {
+			const uint8 fullBits = _tableBits + entry->subBits;
+			if (bitsLeft < fullBits)
+				return getSymbolSlow(bits);
+
+			const uint32 value = bits.peekBits(fullBits);
+			const uint32 index = msb2lsb ? (value & ((1 << entry->subBits) - 1)) : (value >> _tableBits);
+
+			entry = &table[entry->symbol + index];
+		}
+
+		if (entry->length != 0) {
+			bits.skip(entry->length);
+			return entry->symbol;
+		}
+	}
+
+	return getSymbolSlow(bits);
+}
+
+uint32 Huffman::getSymbolSlow(BitStream &bits) const {
 	uint32 code = 0;
 
 	for (uint32 i = 0; i < _codes.size(); i++) {
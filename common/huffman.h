@@ -59,6 +59,9 @@ public:
 	uint32 getSymbol(BitStream &bits) const;
 
 private:
+	/** Maximal number of bits looked up in the first level of the lookup table. */
+	static const uint8 kTableBits = 9;
+
 	struct Symbol {
 		uint32 code;
 		uint32 symbol;
@@ -66,15 +69,62 @@ private:
 		Symbol(uint32 c, uint32 s);
 	};
 
+	/**
+	 * An entry in the lookup table.
+	 *
+	 * If length is not 0, the entry resolves to a symbol. Otherwise, if
+	 * subBits is not 0, symbol is the offset of a second-level table
+	 * indexed by the next subBits bits. If both are 0, the code can't
+	 * be resolved through the table.
+	 */
+	struct TableEntry {
+		uint32 symbol;
+		uint8 length;
+		uint8 subBits;
+
+		TableEntry() : symbol(0), length(0), subBits(0) {}
+	};
+
 	typedef List<Symbol> CodeList;
 	typedef Array<CodeList> CodeLists;
 	typedef Array<Symbol *> SymbolList;
+	typedef Array<TableEntry> LookupTable;
 
 	/** Lists of codes and their symbols, sorted by code length. */
 	CodeLists _codes;
 
 	/** Sorted list of pointers to the symbols. */
 	SymbolList _symbols;
+
+	/** Number of bits indexing the first level of the lookup tables. */
+	uint8 _tableBits;
+
+	/** Lookup table for MSB to LSB bitstreams, first level followed by all second-level tables. */
+	LookupTable _tableMSB;
+	/** Lookup table for LSB to MSB bitstreams, first level followed by all second-level tables. */
+	LookupTable _tableLSB;
+
+	/** (Re)build the lookup tables from the code lists. */
+	void buildTables();
+	/** Build the lookup table for one bit order. */
+	void buildTable(LookupTable &table, bool msb2lsb);
+	/**
+	 * Add a code to a (sub) table.
+	 *
+	 * @param table The lookup table to fill.
+	 * @param offset The offset of the (sub) table within the lookup table.
+	 * @param tableBits Number of bits indexing the (sub) table.
+	 * @param code The part of the code indexing the (sub) table.
+	 * @param length The length of that part of the code.
+	 * @param symbol The symbol of the code.
+	 * @param fullLength The full length of the code.
+	 * @param msb2lsb Is the table for an MSB to LSB bitstream?
+	 */
+	static void fillTable(LookupTable &table, uint32 offset, uint8 tableBits, uint32 code, uint8 length,
+	                      uint32 symbol, uint8 fullLength, bool msb2lsb);
+
+	/** Decode the next symbol by walking all code lengths, bit by bit. */
+	uint32 getSymbolSlow(BitStream &bits) const;
 };
 
 } // End of namespace Common
@@ -170,6 +170,12 @@ public:
 	 */
 	MacResTagArray getResTagArray() const;
 
+	/**
+	 * Given a path, create the path where Mac OS X would place the AppleDouble file
+	 * containing the resource fork (regardless whether or not it exists)
+	 */
+	static String constructAppleDoubleName(const String &path);
+
 private:
 	SeekableReadStream *_stream;
 	String _baseFileName;
@@ -180,12 +186,6 @@ private:
 	bool loadFromMacBinary(SeekableReadStream &stream);
 	bool loadFromAppleDouble(SeekableReadStream &stream);
 
-	/**
-	 * Given a path, create the path where Mac OS X would place the AppleDouble file
-	 * containing the resource fork (regardless whether or not it exists)
-	 */
-	static String constructAppleDoubleName(const String &path);
-
 	/**
 	 * Check if the given stream is in the MacBinary format.
 	 * @param stream The stream we're checking
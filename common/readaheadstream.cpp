@@ -0,0 +1,170 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/readaheadstream.h"
+
+namespace Common {
+
+ReadAheadStream::ReadAheadStream(SeekableReadStream *parentStream, DisposeAfterUse::Flag disposeParentStream, uint32 blockSize, uint blockCount)
+	: _parentStream(parentStream, disposeParentStream),
+	  _size(parentStream->size64()),
+	  _blockSize(blockSize),
+	  _head(0),
+	  _count(0),
+	  _headPos(parentStream->pos64()),
+	  _headOffset(0),
+	  _fetchPos(_headPos),
+	  _parentEos(false),
+	  _eos(false),
+	  _err(false) {
+	assert(blockSize > 0 && blockCount > 0);
+
+	_blocks.resize(blockCount);
+	for (uint i = 0; i < blockCount; i++) {
+		_blocks[i].data = new byte[blockSize];
+		_blocks[i].size = 0;
+	}
+}
+
+ReadAheadStream::~ReadAheadStream() {
+	for (uint i = 0; i < _blocks.size(); i++)
+		delete[] _blocks[i].data;
+}
+
+bool ReadAheadStream::eos() const {
+	return _eos;
+}
+
+bool ReadAheadStream::err() const {
+	return _err;
+}
+
+void ReadAheadStream::clearErr() {
+	_parentStream->clearErr();
+	_eos = false;
+	_err = false;
+}
+
+int64 ReadAheadStream::pos64() const {
+	return _headPos + _headOffset;
+}
+
+bool ReadAheadStream::seek64(int64 offset, int whence) {
+	if (whence == SEEK_CUR)
+		offset += _headPos + _headOffset;
+	else if (whence == SEEK_END)
+		offset += _size;
+
+	if (offset < 0 || offset > _size)
+		return false;
+
+	_eos = false;
+
+	if (offset >= _headPos && offset <= _fetchPos) {
+		// Keep the blocks we are seeking into, and drop the ones before
+		while (_count > 0 && offset >= _headPos + _blocks[_head].size) {
+			_headPos += _blocks[_head].size;
+			_head = (_head + 1) % _blocks.size();
+			_count--;
+		}
+		_headOffset = (uint32)(offset - _headPos);
+	} else {
+		// Drop everything and restart the prefetch at the new position
+		_count = 0;
+		_headPos = _fetchPos = offset;
+		_headOffset = 0;
+		_parentEos = false;
+	}
+
+	return true;
+}
+
+uint32 ReadAheadStream::read(void *dataPtr, uint32 dataSize) {
+	byte *dst = (byte *)dataPtr;
+	uint32 total = 0;
+
+	while (total < dataSize) {
+		if (_count > 0) {
+			Block &block = _blocks[_head];
+			uint32 len = MIN(block.size - _headOffset, dataSize - total);
+			memcpy(dst + total, block.data + _headOffset, len);
+			total += len;
+			_headOffset += len;
+
+			if (_headOffset == block.size) {
+				_headPos += block.size;
+				_headOffset = 0;
+				_head = (_head + 1) % _blocks.size();
+				_count--;
+			}
+			continue;
+		}
+
+		if (_parentEos) {
+			_eos = true;
+			break;
+		}
+
+		if (_err)
+			break;
+
+		// The prefetch has not caught up; read the next block now
+		fillNextBlock();
+	}
+
+	return total;
+}
+
+bool ReadAheadStream::fillNextBlock() {
+	if (_count == _blocks.size() || _parentEos || _err)
+		return false;
+
+	if (_fetchPos >= _size) {
+		_parentEos = true;
+		return false;
+	}
+
+	if (_parentStream->pos64() != _fetchPos && !_parentStream->seek64(_fetchPos)) {
+		_err = true;
+		return false;
+	}
+
+	Block &block = _blocks[(_head + _count) % _blocks.size()];
+	uint32 size = _parentStream->read(block.data, _blockSize);
+
+	if (_parentStream->err()) {
+		_err = true;
+		return false;
+	}
+
+	if (size < _blockSize)
+		_parentEos = true;
+	if (size == 0)
+		return false;
+
+	block.size = size;
+	_fetchPos += size;
+	_count++;
+	return true;
+}
+
+} // End of namespace Common
@@ -0,0 +1,113 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_READAHEADSTREAM_H
+#define COMMON_READAHEADSTREAM_H
+
+#include "common/array.h"
+#include "common/ptr.h"
+#include "common/stream.h"
+#include "common/types.h"
+
+namespace Common {
+
+/**
+ * Wrapper around a SeekableReadStream which reads the parent stream ahead
+ * of the consumer's position while the owner has time to spare, so that
+ * sequential readers such as video decoders do not wait for the disk on
+ * every read.
+ *
+ * The data is prefetched into a ring of fixed size blocks by calls to
+ * fillNextBlock(), e.g. while a video player waits for the next frame. A
+ * read which finds the data already buffered is a plain memcpy; one which
+ * does not reads the next block itself. Seeking within the buffered blocks
+ * keeps them, any other seek drops them and restarts the prefetch at the
+ * new position.
+ *
+ * The parent stream must not be used by anyone else while it is wrapped.
+ * Like other streams, this is not thread safe.
+ */
+class ReadAheadStream : public SeekableReadStream, public NonCopyable {
+public:
+	enum {
+		kDefaultBlockSize = 64 * 1024,
+		kDefaultBlockCount = 8
+	};
+
+	ReadAheadStream(SeekableReadStream *parentStream, DisposeAfterUse::Flag disposeParentStream,
+	                uint32 blockSize = kDefaultBlockSize, uint blockCount = kDefaultBlockCount);
+	virtual ~ReadAheadStream();
+
+	virtual bool eos() const;
+	virtual bool err() const;
+	virtual void clearErr();
+
+	virtual int32 pos() const { return narrowTo32(pos64()); }
+	virtual int32 size() const { return narrowTo32(size64()); }
+	virtual bool seek(int32 offset, int whence = SEEK_SET) { return seek64(offset, whence); }
+
+	virtual int64 pos64() const;
+	virtual int64 size64() const { return _size; }
+	virtual bool seek64(int64 offset, int whence = SEEK_SET);
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize);
+
+	/**
+	 * Read the next block from the parent stream, unless all blocks are
+	 * full or the end of the parent stream has been reached. This blocks
+	 * until the parent stream returns the data, so it should be called when
+	 * the caller would otherwise be idle.
+	 *
+	 * @return true if a block was filled
+	 */
+	bool fillNextBlock();
+
+private:
+	struct Block {
+		byte *data;
+		uint32 size;
+	};
+
+	DisposablePtr<SeekableReadStream> _parentStream;
+	const int64 _size;
+	const uint32 _blockSize;
+	Array<Block> _blocks;
+
+	/** Index of the block the consumer reads from. */
+	uint _head;
+	/** Number of filled blocks, starting at _head. */
+	uint _count;
+	/** Stream position of the start of the head block. */
+	int64 _headPos;
+	/** Consumer offset into the head block. */
+	uint32 _headOffset;
+	/** Stream position the next block is filled from. */
+	int64 _fetchPos;
+
+	bool _parentEos;
+	bool _eos;
+	bool _err;
+};
+
+} // End of namespace Common
+
+#endif
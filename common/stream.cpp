@@ -81,6 +81,17 @@ bool MemoryReadStream::seek(int32 offs, int whence) {
 	return true;	// FIXME: STREAM REWRITE
 }
 
+const byte *MemoryReadStream::borrowData(uint32 dataSize) {
+	if (dataSize > _size - _pos)
+		return 0;
+
+	const byte *ptr = _ptr;
+	_ptr += dataSize;
+	_pos += dataSize;
+
+	return ptr;
+}
+
 bool MemoryWriteStreamDynamic::seek(int32 offs, int whence) {
 	// Pre-Condition
 	assert(_pos <= _size);
@@ -176,6 +187,14 @@ char *SeekableReadStream::readLine(char *buf, size_t bufSize) {
 	return buf;
 }
 
+bool SeekableReadStream::seek64(int64 offset, int whence) {
+	// Streams which do not override this can only address 2 GB
+	if (offset < -0x7FFFFFFF - 1 || offset > 0x7FFFFFFF)
+		return false;
+
+	return seek((int32)offset, whence);
+}
+
 String SeekableReadStream::readLine() {
 	// Read a line
 	String line;
@@ -206,23 +225,23 @@ uint32 SubReadStream::read(void *dataPtr, uint32 dataSize) {
 	return dataSize;
 }
 
-SeekableSubReadStream::SeekableSubReadStream(SeekableReadStream *parentStream, uint32 begin, uint32 end, DisposeAfterUse::Flag disposeParentStream)
+SeekableSubReadStream::SeekableSubReadStream(SeekableReadStream *parentStream, uint64 begin, uint64 end, DisposeAfterUse::Flag disposeParentStream)
 	: SubReadStream(parentStream, end, disposeParentStream),
 	_parentStream(parentStream),
 	_begin(begin) {
 	assert(_begin <= _end);
 	_pos = _begin;
-	_parentStream->seek(_pos);
+	_parentStream->seek64(_pos);
 	_eos = false;
 }
 
-bool SeekableSubReadStream::seek(int32 offset, int whence) {
+bool SeekableSubReadStream::seek64(int64 offset, int whence) {
 	assert(_pos >= _begin);
 	assert(_pos <= _end);
 
 	switch (whence) {
 	case SEEK_END:
-		offset = size() + offset;
+		offset = size64() + offset;
 		// fallthrough
 	case SEEK_SET:
 		_pos = _begin + offset;
@@ -234,12 +253,27 @@ bool SeekableSubReadStream::seek(int32 offset, int whence) {
 	assert(_pos >= _begin);
 	assert(_pos <= _end);
 
-	bool ret = _parentStream->seek(_pos);
+	bool ret = _parentStream->seek64(_pos);
 	if (ret) _eos = false; // reset eos on successful seek
 
 	return ret;
 }
 
+const byte *SeekableSubReadStream::borrowData(uint32 dataSize) {
+	if (dataSize > _end - _pos)
+		return 0;
+
+	// Safe substreams share their parent, so always reposition it first
+	if (!_parentStream->seek64(_pos))
+		return 0;
+
+	const byte *ptr = _parentStream->borrowData(dataSize);
+	if (ptr)
+		_pos += dataSize;
+
+	return ptr;
+}
+
 uint32 SafeSeekableSubReadStream::read(void *dataPtr, uint32 dataSize) {
 	// Make sure the parent stream is at the right position
 	seek(0, SEEK_CUR);
@@ -365,10 +399,13 @@ protected:
 public:
 	BufferedSeekableReadStream(SeekableReadStream *parentStream, uint32 bufSize, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO);
 
-	virtual int32 pos() const { return _parentStream->pos() - (_bufSize - _pos); }
-	virtual int32 size() const { return _parentStream->size(); }
+	virtual int32 pos() const { return narrowTo32(pos64()); }
+	virtual int32 size() const { return narrowTo32(size64()); }
+	virtual bool seek(int32 offset, int whence = SEEK_SET) { return seek64(offset, whence); }
 
-	virtual bool seek(int32 offset, int whence = SEEK_SET);
+	virtual int64 pos64() const { return _parentStream->pos64() - (_bufSize - _pos); }
+	virtual int64 size64() const { return _parentStream->size64(); }
+	virtual bool seek64(int64 offset, int whence = SEEK_SET);
 };
 
 BufferedSeekableReadStream::BufferedSeekableReadStream(SeekableReadStream *parentStream, uint32 bufSize, DisposeAfterUse::Flag disposeParentStream)
@@ -376,27 +413,27 @@ BufferedSeekableReadStream::BufferedSeekableReadStream(SeekableReadStream *paren
 	_parentStream(parentStream) {
 }
 
-bool BufferedSeekableReadStream::seek(int32 offset, int whence) {
+bool BufferedSeekableReadStream::seek64(int64 offset, int whence) {
 	// If it is a "local" seek, we may get away with "seeking" around
 	// in the buffer only.
 	_eos = false;	// seeking always cancels EOS
 
-	int relOffset = 0;
+	int64 relOffset = 0;
 	switch (whence) {
 	case SEEK_SET:
-		relOffset = offset - pos();
+		relOffset = offset - pos64();
 		break;
 	case SEEK_CUR:
 		relOffset = offset;
 		break;
 	case SEEK_END:
-		relOffset = (size() + offset) - pos();
+		relOffset = (size64() + offset) - pos64();
 		break;
 	default:
 		break;
 	}
 
-	if ((int)_pos + relOffset >= 0 && _pos + relOffset <= _bufSize) {
+	if ((int64)_pos + relOffset >= 0 && (int64)_pos + relOffset <= (int64)_bufSize) {
 		_pos += relOffset;
 
 		// Note: we do not need to reset parent's eos flag here. It is
@@ -414,7 +451,7 @@ bool BufferedSeekableReadStream::seek(int32 offset, int whence) {
 		// full advantage of the buffer by saving its actual start position.
 		// This seems not worth the effort for this seemingly uncommon use.
 		_pos = _bufSize = 0;
-		_parentStream->seek(offset, whence);
+		_parentStream->seek64(offset, whence);
 	}
 
 	return true;
@@ -447,12 +447,42 @@ public:
 	 */
 	virtual bool seek(int32 offset, int whence = SEEK_SET) = 0;
 
+	/**
+	 * 64-bit variants of pos(), size() and seek(), for streams which can
+	 * be larger than 2 GB.
+	 *
+	 * By default these just forward to the 32-bit methods, so every stream
+	 * supports them. Streams which can actually grow beyond 2 GB override
+	 * them; their 32-bit pos() and size() then return -1 whenever the value
+	 * does not fit into an int32, and their seek() forwards to seek64().
+	 */
+	virtual int64 pos64() const { return pos(); }
+	virtual int64 size64() const { return size(); }
+	virtual bool seek64(int64 offset, int whence = SEEK_SET);
+
 	/**
 	 * TODO: Get rid of this??? Or keep it and document it
 	 * @return true on success, false in case of a failure
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Gives direct access to the next dataSize bytes of the stream without
+	 * copying them, and advances the stream position past them.
+	 *
+	 * Only streams which keep their whole contents in memory (or map it
+	 * into memory on the first call) can do this. All other streams, and
+	 * requests reaching beyond the end of the stream, return 0 and leave
+	 * the position untouched, in which case the caller has to fall back
+	 * to read().
+	 *
+	 * The returned pointer remains valid until the stream is destroyed.
+	 *
+	 * @param dataSize	number of bytes to borrow
+	 * @return a pointer to the data, or 0 if it can not be borrowed
+	 */
+	virtual const byte *borrowData(uint32 dataSize) { return 0; }
+
 	/**
 	 * Reads at most one less than the number of characters specified
 	 * by bufSize from the and stores them in the string buf. Reading
@@ -490,6 +520,13 @@ public:
 	 * err() or eos() to determine whether an exception occurred.
 	 */
 	virtual String readLine();
+
+protected:
+	/**
+	 * Narrows a 64-bit position or size for the 32-bit API, mapping values
+	 * which do not fit to -1.
+	 */
+	static int32 narrowTo32(int64 value) { return (value <= 0x7FFFFFFF) ? (int32)value : -1; }
 };
 
 /**
@@ -40,11 +40,11 @@ namespace Common {
 class SubReadStream : virtual public ReadStream {
 protected:
 	DisposablePtr<ReadStream> _parentStream;
-	uint32 _pos;
-	uint32 _end;
+	uint64 _pos;
+	uint64 _end;
 	bool _eos;
 public:
-	SubReadStream(ReadStream *parentStream, uint32 end, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO)
+	SubReadStream(ReadStream *parentStream, uint64 end, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO)
 		: _parentStream(parentStream, disposeParentStream),
 		  _pos(0),
 		  _end(end),
@@ -69,14 +69,18 @@ public:
 class SeekableSubReadStream : public SubReadStream, public SeekableReadStream {
 protected:
 	SeekableReadStream *_parentStream;
-	uint32 _begin;
+	uint64 _begin;
 public:
-	SeekableSubReadStream(SeekableReadStream *parentStream, uint32 begin, uint32 end, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO);
+	SeekableSubReadStream(SeekableReadStream *parentStream, uint64 begin, uint64 end, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO);
 
-	virtual int32 pos() const { return _pos - _begin; }
-	virtual int32 size() const { return _end - _begin; }
+	virtual int32 pos() const { return narrowTo32(pos64()); }
+	virtual int32 size() const { return narrowTo32(size64()); }
+	virtual bool seek(int32 offset, int whence = SEEK_SET) { return seek64(offset, whence); }
 
-	virtual bool seek(int32 offset, int whence = SEEK_SET);
+	virtual int64 pos64() const { return _pos - _begin; }
+	virtual int64 size64() const { return _end - _begin; }
+	virtual bool seek64(int64 offset, int whence = SEEK_SET);
+	virtual const byte *borrowData(uint32 dataSize);
 };
 
 /**
@@ -88,7 +92,7 @@ public:
  */
 class SeekableSubReadStreamEndian : public SeekableSubReadStream, public ReadStreamEndian {
 public:
-	SeekableSubReadStreamEndian(SeekableReadStream *parentStream, uint32 begin, uint32 end, bool bigEndian, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO)
+	SeekableSubReadStreamEndian(SeekableReadStream *parentStream, uint64 begin, uint64 end, bool bigEndian, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO)
 		: SeekableSubReadStream(parentStream, begin, end, disposeParentStream),
 		  ReadStreamEndian(bigEndian) {
 	}
@@ -109,7 +113,7 @@ public:
  */
 class SafeSeekableSubReadStream : public SeekableSubReadStream {
 public:
-	SafeSeekableSubReadStream(SeekableReadStream *parentStream, uint32 begin, uint32 end, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO)
+	SafeSeekableSubReadStream(SeekableReadStream *parentStream, uint64 begin, uint64 end, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO)
 		: SeekableSubReadStream(parentStream, begin, end, disposeParentStream) {
 	}
 
@@ -106,10 +106,117 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/ptr.h"
+#include "common/zlib.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
 
+namespace Common {
+
+/**
+ * A view on a part of a zip file. The archive and the streams of its
+ * members all read through such views, and any number of them can be used
+ * at the same time, even from different threads: each read locks the zip
+ * file and seeks to the position of the view first. The zip file is
+ * deleted together with the last view on it, so member streams may outlive
+ * their archive. The views count their references under the same lock, as
+ * member streams may be destroyed on another thread, such as the mixer's.
+ */
+class ZipFileView : public SeekableReadStream, public NonCopyable {
+	struct ZipFile {
+		ZipFile(SeekableReadStream *s) : stream(s), refCount(1) {}
+
+		ScopedPtr<SeekableReadStream> stream;
+		Mutex mutex;
+		/** Number of views on the file, guarded by mutex. */
+		uint refCount;
+	};
+
+	ZipFile *_file;
+	uint64 _begin;
+	uint64 _end;
+	uint64 _pos;
+	bool _eos;
+	bool _err;
+
+public:
+	/** Create a view on a whole zip file, taking ownership of the stream. */
+	ZipFileView(SeekableReadStream *stream)
+		: _file(new ZipFile(stream)), _begin(0), _end(stream->size64()), _pos(0), _eos(false), _err(false) {
+	}
+
+	/** Create a view on the part of the zip file from begin to end. */
+	ZipFileView(const ZipFileView &parent, uint64 begin, uint64 end)
+		: _file(parent._file), _begin(begin), _end(end), _pos(0), _eos(false), _err(false) {
+		assert(_begin <= _end && _end <= parent._end);
+
+		StackLock lock(_file->mutex);
+		_file->refCount++;
+	}
+
+	~ZipFileView() {
+		bool last;
+		{
+			StackLock lock(_file->mutex);
+			last = --_file->refCount == 0;
+		}
+
+		// No other view is left to take the lock
+		if (last)
+			delete _file;
+	}
+
+	bool eos() const { return _eos; }
+	bool err() const { return _err; }
+	void clearErr() { _eos = false; _err = false; }
+
+	int32 pos() const { return narrowTo32(pos64()); }
+	int32 size() const { return narrowTo32(size64()); }
+	bool seek(int32 offset, int whence = SEEK_SET) { return seek64(offset, whence); }
+
+	int64 pos64() const { return _pos; }
+	int64 size64() const { return _end - _begin; }
+
+	bool seek64(int64 offset, int whence = SEEK_SET) {
+		int64 newPos = offset;
+		if (whence == SEEK_CUR)
+			newPos += _pos;
+		else if (whence == SEEK_END)
+			newPos += size64();
+
+		if (newPos < 0 || newPos > size64())
+			return false;
+
+		_pos = newPos;
+		_eos = false;
+		return true;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		if (dataSize > _end - _begin - _pos) {
+			dataSize = _end - _begin - _pos;
+			_eos = true;
+		}
+
+		StackLock lock(_file->mutex);
+
+		if (!_file->stream->seek64(_begin + _pos, SEEK_SET)) {
+			_err = true;
+			return 0;
+		}
+
+		dataSize = _file->stream->read(dataPtr, dataSize);
+		_err |= _file->stream->err();
+		_pos += dataSize;
+		return dataSize;
+	}
+};
+
+} // End of namespace Common
+
 #if defined(STRICTUNZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
     from (void *) without cast */
@@ -472,7 +579,7 @@ static uLong unzlocal_SearchCentralDir(Common::SeekableReadStream &fin) {
 	uLong uMaxBack=0xffff; /* maximum size of global comment */
 	uLong uPosFound=0;
 
-	uSizeFile = fin.size();
+	uSizeFile = (uLong)fin.size64();
 	if (fin.err())
 		return 0;
 
@@ -495,7 +602,7 @@ static uLong unzlocal_SearchCentralDir(Common::SeekableReadStream &fin) {
 
 		uReadSize = ((BUFREADCOMMENT+4) < (uSizeFile-uReadPos)) ?
                      (BUFREADCOMMENT+4) : (uSizeFile-uReadPos);
-		fin.seek(uReadPos, SEEK_SET);
+		fin.seek64(uReadPos, SEEK_SET);
 		if (fin.err())
 			break;
 
@@ -549,7 +656,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	if (central_pos==0)
 		err=UNZ_ERRNO;
 
-	us->_stream->seek(central_pos, SEEK_SET);
+	us->_stream->seek64(central_pos, SEEK_SET);
 	if (us->_stream->err())
 		err=UNZ_ERRNO;
 
@@ -710,7 +817,7 @@ static int unzlocal_GetCurrentFileInfoInternal(unzFile file,
 	if (file==NULL)
 		return UNZ_PARAMERROR;
 	s=(unz_s*)file;
-	s->_stream->seek(s->pos_in_central_dir+s->byte_before_the_zipfile, SEEK_SET);
+	s->_stream->seek64(s->pos_in_central_dir+s->byte_before_the_zipfile, SEEK_SET);
 	if (s->_stream->err())
 		err=UNZ_ERRNO;
 
@@ -963,7 +1070,7 @@ static int unzlocal_CheckCurrentFileCoherencyHeader(unz_s* s, uInt* piSizeVar,
 	*poffset_local_extrafield = 0;
 	*psize_local_extrafield = 0;
 
-	s->_stream->seek(s->cur_file_info_internal.offset_curfile +
+	s->_stream->seek64(s->cur_file_info_internal.offset_curfile +
 								s->byte_before_the_zipfile, SEEK_SET);
 	if (s->_stream->err())
 		return UNZ_ERRNO;
@@ -1125,6 +1232,32 @@ int unzOpenCurrentFile (unzFile file) {
 }
 
 
+/*
+  Get the offset in the zipfile of the data of the current file, after
+  checking its local header.
+  return UNZ_OK if there is no problem. */
+static int unzlocal_GetCurrentFileDataOffset(unzFile file, uLong *poffset) {
+	uInt iSizeVar;
+	unz_s* s;
+	uLong offset_local_extrafield;
+	uInt  size_local_extrafield;
+
+	if (file==NULL)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+	if (!s->current_file_ok)
+		return UNZ_PARAMERROR;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s,&iSizeVar,
+				&offset_local_extrafield,&size_local_extrafield)!=UNZ_OK)
+		return UNZ_BADZIPFILE;
+
+	*poffset = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER +
+		iSizeVar + s->byte_before_the_zipfile;
+	return UNZ_OK;
+}
+
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -1170,7 +1303,7 @@ int unzReadCurrentFile(unzFile file, voidp buf, unsigned len) {
 				uReadThis = (uInt)pfile_in_zip_read_info->rest_read_compressed;
 			if (uReadThis == 0)
 				return UNZ_EOF;
-			pfile_in_zip_read_info->_stream->seek(pfile_in_zip_read_info->pos_in_zipfile +
+			pfile_in_zip_read_info->_stream->seek64(pfile_in_zip_read_info->pos_in_zipfile +
 				pfile_in_zip_read_info->byte_before_the_zipfile, SEEK_SET);
 			if (pfile_in_zip_read_info->_stream->err())
 				return UNZ_ERRNO;
@@ -1332,7 +1465,7 @@ int unzGetLocalExtrafield(unzFile file, voidp buf, unsigned len) {
 	if (read_now==0)
 		return 0;
 
-	pfile_in_zip_read_info->_stream->seek(pfile_in_zip_read_info->offset_local_extrafield +
+	pfile_in_zip_read_info->_stream->seek64(pfile_in_zip_read_info->offset_local_extrafield +
 			  pfile_in_zip_read_info->pos_local_extrafield,SEEK_SET);
 	if (pfile_in_zip_read_info->_stream->err())
 		return UNZ_ERRNO;
@@ -1401,7 +1534,7 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 	if (uReadThis>s->gi.size_comment)
 		uReadThis = s->gi.size_comment;
 
-	s->_stream->seek(s->central_pos+22, SEEK_SET);
+	s->_stream->seek64(s->central_pos+22, SEEK_SET);
 	if (s->_stream->err())
 		return UNZ_ERRNO;
 
@@ -1419,6 +1552,10 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 
 namespace Common {
 
+enum {
+	// Deflated members up to this size are decompressed into memory at once
+	kMaxInMemoryMemberSize = 256 * 1024
+};
 
 class ZipArchive : public Archive {
 	unzFile _zipFile;
@@ -1490,10 +1627,29 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 		return 0;
 
 	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
+	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
 		return 0;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+	// Stored members are read straight from the zip file, and big deflated
+	// ones are decompressed while they are read
+	if (fileInfo.compression_method == 0 ||
+	    (fileInfo.compression_method == Z_DEFLATED && fileInfo.uncompressed_size > kMaxInMemoryMemberSize)) {
+		uLong offset;
+		if (unzlocal_GetCurrentFileDataOffset(_zipFile, &offset) != UNZ_OK)
+			return 0;
+
+		// makeZipArchive() always opens the zip file through a ZipFileView
+		const ZipFileView *file = (const ZipFileView *)((const unz_s *)_zipFile)->_stream;
+		if ((uint64)offset + fileInfo.compressed_size > (uint64)file->size64())
+			return 0;
+
+		SeekableReadStream *data = new ZipFileView(*file, offset, offset + fileInfo.compressed_size);
+		if (fileInfo.compression_method == 0)
+			return data;
+		return wrapDeflateReadStream(data, fileInfo.uncompressed_size);
+	}
+
+	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
 		return 0;
 
 	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
@@ -1510,11 +1666,6 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	}
 
 	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
-
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
 }
 
 Archive *makeZipArchive(const String &name) {
@@ -1528,7 +1679,7 @@ Archive *makeZipArchive(const FSNode &node) {
 Archive *makeZipArchive(SeekableReadStream *stream) {
 	if (!stream)
 		return 0;
-	unzFile zipFile = unzOpen(stream);
+	unzFile zipFile = unzOpen(new ZipFileView(stream));
 	if (!zipFile) {
 		// stream gets deleted by unzOpen() call if something
 		// goes wrong.
@@ -23,6 +23,7 @@
 // Based on the ScummVM (GPLv2+) file of the same name
 
 #include "common/zlib.h"
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -147,12 +148,30 @@ static bool _shownBackwardSeekingWarning = false;
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other SeekableReadStream and will then provide on-the-fly decompression support.
- * Assumes the compressed data to be in gzip format.
+ * Assumes the compressed data to be in gzip or zlib format, or to be raw
+ * deflate data if so requested.
+ *
+ * While decompressing, the stream records a restart point about every
+ * kRestartSpan bytes of output. Seeking, backward or far forward, resumes
+ * decompression from the closest restart point instead of the start.
  */
 class GZipReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,		// 1 << MAX_WBITS
+		kWindowSize = 32768,	// the size of the deflate history window
+		kRestartSpan = 1024 * 1024
+	};
+
+	/**
+	 * The state needed to resume inflating from the start of a deflate block.
+	 */
+	struct RestartPoint {
+		uint32 outPos;		///< position in the decompressed data
+		uint32 inPos;		///< position of the first unused byte in the wrapped stream
+		int bits;			///< unused bits in the byte before inPos
+		uint windowSize;
+		byte *window;		///< the data preceding outPos, up to kWindowSize bytes
 	};
 
 	byte	_buf[BUFSIZE];
@@ -160,40 +179,99 @@ protected:
 	ScopedPtr<SeekableReadStream> _wrapped;
 	z_stream _stream;
 	int _zlibErr;
+	int _windowBits;
 	uint32 _pos;
 	uint32 _origSize;
 	bool _eos;
 
+	Array<RestartPoint> _restartPoints;
+
+	void addRestartPoint(uint32 outPos) {
+#if ZLIB_VERNUM >= 0x1280
+		if (!_restartPoints.empty() && outPos < _restartPoints.back().outPos + kRestartSpan)
+			return;
+
+		RestartPoint point;
+		point.outPos = outPos;
+		point.inPos = _wrapped->pos() - _stream.avail_in;
+		point.bits = _stream.data_type & 7;
+		point.window = (byte *)malloc(kWindowSize);
+		assert(point.window);
+		point.windowSize = kWindowSize;
+		if (inflateGetDictionary(&_stream, point.window, &point.windowSize) != Z_OK) {
+			free(point.window);
+			return;
+		}
+
+		_restartPoints.push_back(point);
+#endif
+	}
+
+	bool restart(const RestartPoint &point) {
+#if ZLIB_VERNUM >= 0x1280
+		_zlibErr = inflateReset2(&_stream, -MAX_WBITS);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		if (point.bits) {
+			_wrapped->seek(point.inPos - 1, SEEK_SET);
+			byte value = _wrapped->readByte();
+			_zlibErr = inflatePrime(&_stream, point.bits, value >> (8 - point.bits));
+		} else {
+			_wrapped->seek(point.inPos, SEEK_SET);
+		}
+
+		if (_zlibErr == Z_OK)
+			_zlibErr = inflateSetDictionary(&_stream, point.window, point.windowSize);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_pos = point.outPos;
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		return true;
+#else
+		return false;
+#endif
+	}
+
 public:
 
-	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0) : _wrapped(w), _stream() {
+	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0, bool rawDeflate = false) : _wrapped(w), _stream() {
 		assert(w != 0);
 
-		// Verify file header is correct
-		w->seek(0, SEEK_SET);
-		uint16 header = w->readUint16BE();
-		assert(header == 0x1F8B ||
-		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
-
-		if (header == 0x1F8B) {
-			// Retrieve the original file size
-			w->seek(-4, SEEK_END);
-			_origSize = w->readUint32LE();
-		} else {
-			// Original size not available in zlib format
-			// use an otherwise known size if supplied.
+		if (rawDeflate) {
 			_origSize = knownSize;
+			_windowBits = -MAX_WBITS;
+		} else {
+			// Verify file header is correct
+			w->seek(0, SEEK_SET);
+			uint16 header = w->readUint16BE();
+			assert(header == 0x1F8B ||
+			       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+
+			if (header == 0x1F8B) {
+				// Retrieve the original file size
+				w->seek(-4, SEEK_END);
+				_origSize = w->readUint32LE();
+			} else {
+				// Original size not available in zlib format
+				// use an otherwise known size if supplied.
+				_origSize = knownSize;
+			}
+
+			// Adding 32 to windowBits indicates to zlib that it is supposed to
+			// automatically detect whether gzip or zlib headers are used for
+			// the compressed file. This feature was added in zlib 1.2.0.4,
+			// released 10 August 2003.
+			// Note: This is *crucial* for savegame compatibility, do *not* remove!
+			_windowBits = MAX_WBITS + 32;
 		}
 		_pos = 0;
 		w->seek(0, SEEK_SET);
 		_eos = false;
 
-		// Adding 32 to windowBits indicates to zlib that it is supposed to
-		// automatically detect whether gzip or zlib headers are used for
-		// the compressed file. This feature was added in zlib 1.2.0.4,
-		// released 10 August 2003.
-		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		_zlibErr = inflateInit2(&_stream, _windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -204,6 +282,9 @@ public:
 
 	~GZipReadStream() {
 		inflateEnd(&_stream);
+
+		for (uint i = 0; i < _restartPoints.size(); i++)
+			free(_restartPoints[i].window);
 	}
 
 	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
@@ -223,7 +304,12 @@ public:
 				_stream.next_in = _buf;
 				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+			_zlibErr = inflate(&_stream, Z_BLOCK);
+
+			// Z_BLOCK makes inflate stop at the end of each deflate block
+			// (and of the header), where restarting is possible
+			if (_zlibErr == Z_OK && (_stream.data_type & 128) && !(_stream.data_type & 64))
+				addRestartPoint(_pos + dataSize - _stream.avail_out);
 		}
 
 		// Update the position counter
@@ -261,7 +347,15 @@ public:
 
 		assert(newPos >= 0);
 
-		if ((uint32)newPos < _pos) {
+		// Find the closest restart point before the new position
+		int point = (int)_restartPoints.size() - 1;
+		while (point >= 0 && _restartPoints[point].outPos > (uint32)newPos)
+			point--;
+
+		if (point >= 0 && ((uint32)newPos < _pos || _restartPoints[point].outPos > _pos)) {
+			if (!restart(_restartPoints[point]))
+				return false;	// FIXME: STREAM REWRITE
+		} else if ((uint32)newPos < _pos) {
 			// To search backward, we have to restart the whole decompression
 			// from the start of the file. A rather wasteful operation, best
 			// to avoid it. :/
@@ -278,7 +372,12 @@ public:
 
 			_pos = 0;
 			_wrapped->seek(0, SEEK_SET);
+#if ZLIB_VERNUM >= 0x1280
+			// A restart may have switched the inflater to raw deflate
+			_zlibErr = inflateReset2(&_stream, _windowBits);
+#else
 			_zlibErr = inflateReset(&_stream);
+#endif
 			if (_zlibErr != Z_OK)
 				return false;	// FIXME: STREAM REWRITE
 			_stream.next_in = _buf;
@@ -287,9 +386,8 @@ public:
 
 		offset = newPos - _pos;
 
-		// Skip the given amount of data (very inefficient if one tries to skip
-		// huge amounts of data, but usually client code will only skip a few
-		// bytes, so this should be fine.
+		// Skip the given amount of data. Thanks to the restart points, this
+		// is at most kRestartSpan bytes, unless they are not supported.
 		byte tmpBuf[1024];
 		while (!err() && offset > 0) {
 			offset -= read(tmpBuf, MIN((int32)sizeof(tmpBuf), offset));
@@ -427,6 +525,18 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, ui
 	return toBeWrapped;
 }
 
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 uncompressedSize) {
+	if (!toBeWrapped)
+		return 0;
+
+#if defined(USE_ZLIB)
+	return new GZipReadStream(toBeWrapped, uncompressedSize, true);
+#else
+	delete toBeWrapped;
+	return 0;
+#endif
+}
+
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
 #if defined(USE_ZLIB)
 	if (toBeWrapped)
@@ -120,6 +120,22 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
  */
 SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize = 0);
 
+/**
+ * Take an arbitrary SeekableReadStream holding raw deflate data, i.e.
+ * without any zlib or gzip header, like the members of zip archives, and
+ * wrap it in a custom stream which provides on-the-fly decompression.
+ * Seeking resumes decompressing from restart points recorded along the way,
+ * so only backward seeks into data which was never read before need to
+ * restart from the beginning.
+ *
+ * The wrapped stream is destroyed together with the returned stream. If
+ * there is no ZLIB support, it is destroyed right away and NULL is returned.
+ *
+ * @param toBeWrapped		the stream to be wrapped
+ * @param uncompressedSize	the size of the decompressed data
+ */
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 uncompressedSize);
+
 /**
  * Take an arbitrary WriteStream and wrap it in a custom stream which provides
  * transparent on-the-fly compression. The compressed data is written in the
@@ -12,7 +12,13 @@ MODULE_DIRS += \
 DEVTOOLS := \
 	devtools/convbdf$(EXEEXT) \
 	devtools/md5table$(EXEEXT) \
-	devtools/make-scumm-fontdata$(EXEEXT)
+	devtools/make-scumm-fontdata$(EXEEXT) \
+	devtools/video_bench$(EXEEXT)
+
+ifdef POSIX
+DEVTOOLS += \
+	devtools/stream_bench$(EXEEXT)
+endif
 
 include $(srcdir)/devtools/*/module.mk
 
@@ -44,6 +50,18 @@ devtools/make-scumm-fontdata$(EXEEXT): $(srcdir)/devtools/make-scumm-fontdata.c
 	$(QUIET)$(MKDIR) devtools/$(DEPDIR)
 	$(QUIET_LINK)$(LD) $(CFLAGS) -Wall -o $@ $<
 
+VIDEO_BENCH_LIBS := video/libvideo.a image/libimage.a audio/libaudio.a graphics/libgraphics.a common/libcommon.a
+
+devtools/video_bench$(EXEEXT): $(srcdir)/devtools/video_bench.cpp $(VIDEO_BENCH_LIBS)
+	$(QUIET)$(MKDIR) devtools/$(DEPDIR)
+	$(QUIET_LINK)$(CXX) $(CXXFLAGS) $(CPPFLAGS) -o $@ $+ $(LIBS)
+
+STREAM_BENCH_LIBS := backends/fs/posix/mmapstream.o backends/fs/stdiostream.o common/libcommon.a
+
+devtools/stream_bench$(EXEEXT): $(srcdir)/devtools/stream_bench.cpp $(STREAM_BENCH_LIBS)
+	$(QUIET)$(MKDIR) devtools/$(DEPDIR)
+	$(QUIET_LINK)$(CXX) $(CXXFLAGS) $(CPPFLAGS) -o $@ $+ $(LIBS)
+
 #
 # Rules to explicitly rebuild the credits / MD5 tables.
 # The rules for the files in the "web" resp. "docs" modules
@@ -0,0 +1,208 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Random access file reading benchmark.
+ *
+ * Reads records at random offsets of each file, the way engines read
+ * resources from their bundles, and parses each record from a
+ * MemoryReadStream. This is done three times with the same offsets:
+ *
+ *  - stdio:  StdioStream, reading each record into a buffer
+ *  - read:   MmapStream once mapped, reading each record into a buffer
+ *  - borrow: MmapStream once mapped, parsing each record in place with
+ *            borrowData()
+ *
+ * The files are read once before the measurements, so that all of them run
+ * on the page cache.
+ */
+
+// The tool talks to stdio and the OS clock directly
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/scummsys.h"
+#include "common/memstream.h"
+#include "common/str.h"
+#include "common/util.h"
+
+#include "backends/fs/stdiostream.h"
+#include "backends/fs/posix/mmapstream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+namespace {
+
+enum Mode {
+	kModeStdio,
+	kModeRead,
+	kModeBorrow
+};
+
+const char *const kModeNames[] = { "stdio", "read", "borrow" };
+
+struct Options {
+	uint32 recordSize;
+	uint32 reads;
+};
+
+/** Real (monotonic) time in microseconds, for the measurements. */
+uint64 getMicros() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/** Parse a record the way resource loaders do, a little endian word at a time */
+uint32 parseRecord(const byte *data, uint32 size) {
+	Common::MemoryReadStream stream(data, size);
+	uint32 sum = 0;
+	while (stream.pos() + 2 <= (int32)size)
+		sum = (sum << 1 | sum >> 31) ^ stream.readUint16LE();
+	return sum;
+}
+
+/**
+ * Read the records of one mode. Returns a checksum of all records, which
+ * is the same for all modes.
+ */
+uint32 readRecords(Common::SeekableReadStream &stream, Mode mode, const Options &options, uint32 fileSize, byte *buffer) {
+	uint32 seed = 1;
+	uint32 sum = 0;
+
+	for (uint32 i = 0; i < options.reads; i++) {
+		seed = seed * 1103515245 + 12345;
+		uint32 offset = (uint32)(((uint64)seed << 16 | (seed >> 16)) % (fileSize - options.recordSize + 1));
+
+		stream.seek(offset);
+
+		const byte *data = buffer;
+		if (mode == kModeBorrow)
+			data = stream.borrowData(options.recordSize);
+		else
+			stream.read(buffer, options.recordSize);
+
+		sum += parseRecord(data, options.recordSize);
+	}
+
+	return sum;
+}
+
+bool benchmarkFile(const char *path, const Options &options) {
+	MmapStream *mapped = MmapStream::makeFromPath(path);
+	StdioStream *stdio = StdioStream::makeFromPath(path, false);
+	if (!mapped || !stdio) {
+		fprintf(stderr, "%s: Unable to open the file\n", path);
+		delete mapped;
+		delete stdio;
+		return false;
+	}
+
+	uint32 fileSize = stdio->size();
+	byte *buffer = new byte[MAX<uint32>(options.recordSize, 64 * 1024)];
+
+	// Borrowing nothing maps the file
+	if (fileSize < options.recordSize || !mapped->borrowData(0)) {
+		fprintf(stderr, "%s: The file is too small to be mapped, or can not be mapped\n", path);
+		delete[] buffer;
+		delete mapped;
+		delete stdio;
+		return false;
+	}
+
+	// Warm up the page cache
+	while (stdio->read(buffer, 64 * 1024) == 64 * 1024)
+		;
+	stdio->clearErr();
+
+	printf("%s: %u bytes, %u reads of %u bytes\n", path, fileSize, options.reads, options.recordSize);
+
+	uint32 sums[ARRAYSIZE(kModeNames)];
+	uint64 baseTime = 0;
+
+	for (int mode = 0; mode < ARRAYSIZE(kModeNames); mode++) {
+		Common::SeekableReadStream &stream = mode == kModeStdio ? (Common::SeekableReadStream &)*stdio : *mapped;
+
+		uint64 start = getMicros();
+		sums[mode] = readRecords(stream, (Mode)mode, options, fileSize, buffer);
+		uint64 time = MAX<uint64>(getMicros() - start, 1);
+		if (mode == kModeStdio)
+			baseTime = time;
+
+		printf("  %-6s %8.1f MB/s %10.0f reads/s  %5.2fx  checksum %08x\n", kModeNames[mode],
+			(double)options.reads * options.recordSize / time, (double)options.reads * 1000000 / time,
+			(double)baseTime / time, sums[mode]);
+	}
+
+	delete[] buffer;
+	delete mapped;
+	delete stdio;
+
+	if (sums[kModeRead] != sums[kModeStdio] || sums[kModeBorrow] != sums[kModeStdio]) {
+		fprintf(stderr, "%s: The checksums differ\n", path);
+		return false;
+	}
+
+	return true;
+}
+
+void printUsage(const char *name) {
+	printf("Usage: %s [--record BYTES] [--reads N] FILE...\n", name);
+	printf("Reads records at random offsets of each file through stdio, through\n");
+	printf("a memory mapping, and in place with borrowData(), and reports the\n");
+	printf("throughput of each. Files have to be at least %u bytes large.\n", MmapStream::kMinMapSize);
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[]) {
+	Options options;
+	options.recordSize = 512;
+	options.reads = 1000000;
+
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+			options.recordSize = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--reads") && i + 1 < argc) {
+			options.reads = atoi(argv[++i]);
+		} else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (i == argc || options.recordSize == 0) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	int failed = 0;
+
+	for (; i < argc; i++)
+		if (!benchmarkFile(argv[i], options))
+			failed++;
+
+	return failed ? 1 : 0;
+}
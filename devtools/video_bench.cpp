@@ -0,0 +1,689 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Headless video decoding benchmark.
+ *
+ * Opens each file with the matching VideoDecoder, decodes all frames and
+ * audio without a display and reports the decoding speed, the per-frame
+ * decoding times, the peak memory use of the process and a checksum of the
+ * decoded frames.
+ *
+ * Playback runs on a virtual clock, which is advanced to the next frame as
+ * soon as the previous one is decoded, so the benchmark runs as fast as the
+ * decoder allows. The audio is mixed along with the clock.
+ */
+
+// The tool talks to stdio and the OS clock directly
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// The Windows headers have to come first, as they define ARRAYSIZE as well
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#undef ARRAYSIZE // winnt.h defines ARRAYSIZE, but we want our own one...
+#elif defined(POSIX)
+#include <sys/resource.h>
+#endif
+
+#include "common/scummsys.h"
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/stream.h"
+#include "common/str.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/timer.h"
+
+#include "audio/mixer_intern.h"
+
+#include "graphics/surface.h"
+
+#include "video/avi_decoder.h"
+#include "video/bink_decoder.h"
+#include "video/coktel_decoder.h"
+#include "video/dxa_decoder.h"
+#include "video/flic_decoder.h"
+#include "video/mpegps_decoder.h"
+#include "video/psx_decoder.h"
+#include "video/qt_decoder.h"
+#include "video/smk_decoder.h"
+
+#ifdef USE_THEORADEC
+#include "video/ogg_decoder.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(ENABLE_GOB) || defined(ENABLE_SCI32) || defined(DYNAMIC_MODULES)
+#define VIDEO_BENCH_COKTEL
+#endif
+
+namespace {
+
+enum {
+	kOutputRate = 44100,
+	// Clock steps once only audio is left, like a 10ms sound card buffer
+	kAudioStep = 10,
+	// Give up on audio that does not end this long after the last frame
+	kMaxAudioTail = 10 * 60 * 1000
+};
+
+/** Real (monotonic) time in microseconds, for the measurements. */
+uint64 getMicros() {
+#if defined(WIN32)
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (uint64)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+		(uint64)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#elif defined(POSIX)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+	// Processor time, which is all the decoding does anyway
+	return (uint64)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/**
+ * Peak resident memory of the whole process so far in KiB, or 0 if it is
+ * not known. As the files are decoded one after the other, this includes
+ * the files decoded before; run the tool once per file to measure each.
+ */
+uint32 getPeakMemory() {
+#if defined(POSIX)
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+#ifdef MACOSX
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Runs the timers installed while decoding on the virtual clock, from the
+ * main thread.
+ */
+class BenchTimerManager : public Common::TimerManager {
+public:
+	BenchTimerManager() : _now(0) {}
+
+	bool installTimerProc(TimerProc proc, int32 interval, void *refCon, const Common::String &id) {
+		Slot slot;
+		slot.proc = proc;
+		slot.interval = interval;
+		slot.refCon = refCon;
+		slot.nextFire = _now + interval;
+		_slots.push_back(slot);
+		return true;
+	}
+
+	void removeTimerProc(TimerProc proc) {
+		for (uint i = 0; i < _slots.size(); i++) {
+			if (_slots[i].proc == proc) {
+				_slots.remove_at(i);
+				return;
+			}
+		}
+	}
+
+	/** Move the clock forward to the given time, firing all timers due. */
+	void advance(uint64 now) {
+		_now = now;
+
+		// A timer may remove itself, so check the index every time
+		for (uint i = 0; i < _slots.size(); i++) {
+			while (i < _slots.size() && _slots[i].nextFire <= _now) {
+				_slots[i].nextFire += _slots[i].interval;
+				_slots[i].proc(_slots[i].refCon);
+			}
+		}
+	}
+
+private:
+	struct Slot {
+		TimerProc proc;
+		uint64 interval;
+		void *refCon;
+		uint64 nextFire;
+	};
+
+	uint64 _now;
+	Common::Array<Slot> _slots;
+};
+
+/**
+ * A headless OSystem, running on a virtual clock.
+ *
+ * There is no screen, no input and a single thread. Only what the video
+ * decoders use is implemented.
+ */
+class BenchSystem : public OSystem {
+public:
+	BenchSystem() : _millis(0), _mixedFrames(0) {
+		_timer = new BenchTimerManager();
+		_timerManager = _timer;
+
+		// The mixer needs g_system for its mutex
+		g_system = this;
+		_mixer = new Audio::MixerImpl(this, kOutputRate);
+		_mixer->setReady(true);
+	}
+
+	~BenchSystem() {
+		delete _mixer;
+		g_system = 0;
+	}
+
+	/**
+	 * Move the virtual clock forward, mixing the audio for that time.
+	 *
+	 * @return the number of audio frames mixed from the sounds playing
+	 */
+	uint32 advance(uint32 millis) {
+		uint32 mixed = 0;
+
+		for (uint32 step = 0; step < millis; step += kAudioStep) {
+			uint32 delta = MIN<uint32>(kAudioStep, millis - step);
+			_millis += delta;
+
+			// Hand out exactly kOutputRate frames per second
+			uint64 target = (uint64)_millis * kOutputRate / 1000;
+			uint32 frames = target - _mixedFrames;
+			_mixedFrames = target;
+
+			_buffer.resize(frames * 2);
+			if (frames != 0)
+				mixed += _mixer->mixCallback((byte *)_buffer.begin(), frames * 4);
+
+			_timer->advance((uint64)_millis * 1000);
+		}
+
+		return mixed;
+	}
+
+	uint32 getMillis() { return _millis; }
+	void delayMillis(uint msecs) { advance(msecs); }
+	void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+
+	Audio::Mixer *getMixer() { return _mixer; }
+
+	MutexRef createMutex() { return MutexRef(); }
+	void lockMutex(MutexRef mutex) {}
+	void unlockMutex(MutexRef mutex) {}
+	void deleteMutex(MutexRef mutex) {}
+
+	void logMessage(LogMessageType::Type type, const char *message) {
+		fputs(message, type == LogMessageType::kInfo ? stdout : stderr);
+	}
+
+	void quit() { exit(0); }
+	void displayMessageOnOSD(const char *msg) {}
+
+	// No screen
+	const GraphicsMode *getSupportedGraphicsModes() const { return s_noGraphicsModes; }
+	int getDefaultGraphicsMode() const { return 0; }
+	bool setGraphicsMode(int mode) { return mode == 0; }
+	int getGraphicsMode() const { return 0; }
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	int16 getHeight() { return 0; }
+	int16 getWidth() { return 0; }
+	PaletteManager *getPaletteManager() { return 0; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	Graphics::Surface *lockScreen() { return 0; }
+	void unlockScreen() {}
+	void fillScreen(uint32 col) {}
+	void updateScreen() {}
+	void setShakePos(int shakeOffset) {}
+	void showOverlay() {}
+	void hideOverlay() {}
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	void clearOverlay() {}
+	void grabOverlay(void *buf, int pitch) {}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	int16 getOverlayHeight() { return 0; }
+	int16 getOverlayWidth() { return 0; }
+	bool showMouse(bool visible) { return false; }
+	void warpMouse(int x, int y) {}
+	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+
+private:
+	static const GraphicsMode s_noGraphicsModes[];
+
+	uint32 _millis;
+	uint64 _mixedFrames;
+	BenchTimerManager *_timer;
+	Audio::MixerImpl *_mixer;
+	Common::Array<int16> _buffer;
+};
+
+const OSystem::GraphicsMode BenchSystem::s_noGraphicsModes[] = {
+	{ 0, 0, 0 }
+};
+
+/** A read stream on a stdio file, so that no file system backend is needed. */
+class StdioReadStream : public Common::SeekableReadStream {
+public:
+	StdioReadStream(FILE *file) : _file(file), _eos(false) {
+		fseek(_file, 0, SEEK_END);
+		_size = ftell(_file);
+		fseek(_file, 0, SEEK_SET);
+	}
+
+	~StdioReadStream() {
+		fclose(_file);
+	}
+
+	bool err() const { return ferror(_file) != 0; }
+	void clearErr() { clearerr(_file); _eos = false; }
+	bool eos() const { return _eos; }
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		uint32 count = fread(dataPtr, 1, dataSize, _file);
+		if (count < dataSize)
+			_eos = true;
+		return count;
+	}
+
+	int32 pos() const { return ftell(_file); }
+	int32 size() const { return _size; }
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		_eos = false;
+		return fseek(_file, offset, whence) == 0;
+	}
+
+private:
+	FILE *_file;
+	int32 _size;
+	bool _eos;
+};
+
+/** Adler-32 of all decoded frames and palettes. */
+class Checksum {
+public:
+	Checksum() : _a(1), _b(0) {}
+
+	void update(const byte *data, uint32 size) {
+		while (size) {
+			// Largest block that can not overflow before the modulo
+			uint32 block = MIN<uint32>(size, 5552);
+			size -= block;
+
+			while (block--) {
+				_a += *data++;
+				_b += _a;
+			}
+
+			_a %= 65521;
+			_b %= 65521;
+		}
+	}
+
+	void update(const Graphics::Surface &surface) {
+		uint32 rowSize = surface.getWidth() * surface.getFormat().bytesPerPixel;
+
+		for (int y = 0; y < surface.getHeight(); y++)
+			update((const byte *)surface.getBasePtr(0, y), rowSize);
+	}
+
+	uint32 get() const { return (_b << 16) | _a; }
+
+private:
+	uint32 _a, _b;
+};
+
+struct Options {
+	const char *decoder;
+	Graphics::PixelFormat format;
+	bool hasFormat;
+	uint decodeAhead;
+	bool csv;
+};
+
+struct Result {
+	Result() : width(0), height(0), frames(0), shownFrames(0), audioFrames(0), totalTime(0), lateFrames(0) {}
+
+	uint16 width, height;
+	uint32 frames;      ///< Calls to decodeNextFrame()
+	uint32 shownFrames; ///< Calls which returned a frame
+	uint32 audioFrames; ///< Audio frames mixed from the video's sounds
+	uint64 totalTime;   ///< Microseconds for decoding all frames and audio
+	uint32 lateFrames;  ///< Frames decoded on demand while decoding ahead
+	Common::Array<uint32> frameTimes; ///< Microseconds per decodeNextFrame()
+	Checksum checksum;
+};
+
+BenchSystem *g_bench = 0;
+
+bool needsUpdate(Video::VideoDecoder &video) {
+	return video.needsUpdate();
+}
+
+bool decodeAhead(Video::VideoDecoder &video) {
+	return video.decodeAhead();
+}
+
+#ifdef VIDEO_BENCH_COKTEL
+bool needsUpdate(Video::CoktelDecoder &video) {
+	return !video.endOfVideo() && video.getTimeToNextFrame() == 0;
+}
+
+bool decodeAhead(Video::CoktelDecoder &video) {
+	return false;
+}
+#endif
+
+/**
+ * Decode all frames and audio of a loaded video, following the virtual
+ * clock like an engine would follow the real one.
+ */
+template<class Decoder>
+void decodeAll(Decoder &video, Result &result) {
+	result.width = video.getWidth();
+	result.height = video.getHeight();
+
+	uint64 start = getMicros();
+	uint32 lastFrameTime = g_bench->getMillis();
+
+	while (!video.endOfVideo()) {
+		if (!needsUpdate(video)) {
+			// Use the time until the next frame like a player would
+			if (decodeAhead(video))
+				continue;
+
+			// Let the clock run to the next frame, or on with the audio
+			uint32 delay = video.getTimeToNextFrame();
+			if (delay == 0)
+				delay = kAudioStep;
+
+			result.audioFrames += g_bench->advance(delay);
+
+			if (g_bench->getMillis() - lastFrameTime > kMaxAudioTail) {
+				warning("Audio did not end %d seconds after the last frame", kMaxAudioTail / 1000);
+				break;
+			}
+
+			continue;
+		}
+
+		uint64 frameStart = getMicros();
+		const Graphics::Surface *surface = video.decodeNextFrame();
+		result.frameTimes.push_back(getMicros() - frameStart);
+		result.frames++;
+		lastFrameTime = g_bench->getMillis();
+
+		// Keep the checksum out of the measured time
+		uint64 checksumStart = getMicros();
+
+		if (video.hasDirtyPalette())
+			result.checksum.update(video.getPalette(), 256 * 3);
+
+		if (surface) {
+			result.checksum.update(*surface);
+			result.shownFrames++;
+		}
+
+		start += getMicros() - checksumStart;
+	}
+
+	result.totalTime = getMicros() - start;
+}
+
+Video::VideoDecoder *createDecoder(const Common::String &name) {
+	if (name == "avi")
+		return new Video::AVIDecoder();
+	if (name == "bink")
+		return new Video::BinkDecoder();
+	if (name == "dxa")
+		return new Video::DXADecoder();
+	if (name == "flic")
+		return new Video::FlicDecoder();
+	if (name == "mpegps")
+		return new Video::MPEGPSDecoder();
+	if (name == "psx")
+		return new Video::PSXStreamDecoder(Video::PSXStreamDecoder::kCD2x);
+	if (name == "quicktime")
+		return new Video::QuickTimeDecoder();
+	if (name == "smacker")
+		return new Video::SmackerDecoder();
+#ifdef USE_THEORADEC
+	if (name == "theora")
+		return new Video::OggDecoder();
+#endif
+#ifdef VIDEO_BENCH_COKTEL
+	if (name == "vmd")
+		return new Video::AdvancedVMDDecoder();
+#endif
+
+	return 0;
+}
+
+/** Pick the decoder from the file extension. */
+const char *detectDecoder(Common::String fileName) {
+	fileName.toLowercase();
+
+	static const struct {
+		const char *extension;
+		const char *decoder;
+	} extensions[] = {
+		{ ".avi", "avi" },
+		{ ".bik", "bink" },
+		{ ".bk2", "bink" },
+		{ ".dxa", "dxa" },
+		{ ".fli", "flic" },
+		{ ".flc", "flic" },
+		{ ".mpg", "mpegps" },
+		{ ".vob", "mpegps" },
+		{ ".str", "psx" },
+		{ ".mov", "quicktime" },
+		{ ".qt", "quicktime" },
+		{ ".smk", "smacker" },
+		{ ".ogv", "theora" },
+		{ ".ogg", "theora" },
+		{ ".vmd", "vmd" },
+		{ ".imd", "imd" },
+		{ 0, 0 }
+	};
+
+	for (int i = 0; extensions[i].extension; i++)
+		if (fileName.hasSuffix(extensions[i].extension))
+			return extensions[i].decoder;
+
+	return 0;
+}
+
+bool benchmarkFile(const char *fileName, const Options &options, Result &result, Common::String &decoderName) {
+	const char *name = options.decoder ? options.decoder : detectDecoder(fileName);
+	if (!name) {
+		warning("%s: Unknown video type, use --decoder", fileName);
+		return false;
+	}
+
+	decoderName = name;
+
+	FILE *file = fopen(fileName, "rb");
+	if (!file) {
+		warning("%s: Could not open the file", fileName);
+		return false;
+	}
+
+	StdioReadStream *stream = new StdioReadStream(file);
+
+#ifdef VIDEO_BENCH_COKTEL
+	if (decoderName == "imd") {
+		Video::IMDDecoder video(g_bench->getMixer());
+
+		if (!video.loadStream(stream)) {
+			warning("%s: Could not load the video", fileName);
+			return false;
+		}
+
+		decodeAll(video, result);
+		return true;
+	}
+#endif
+
+	Video::VideoDecoder *video = createDecoder(decoderName);
+	if (!video) {
+		warning("%s: No %s decoder in this build", fileName, decoderName.c_str());
+		delete stream;
+		return false;
+	}
+
+	if (options.hasFormat)
+		video->setDefaultHighColorFormat(options.format);
+
+	video->setDecodeAhead(options.decodeAhead);
+
+	if (!video->loadStream(stream)) {
+		warning("%s: Could not load the video", fileName);
+		delete video;
+		return false;
+	}
+
+	video->start();
+	decodeAll(*video, result);
+	result.lateFrames = video->getDecodeAheadStats().lateFrames;
+
+	delete video;
+	return true;
+}
+
+double toMillis(uint32 micros) {
+	return micros / 1000.0;
+}
+
+uint32 percentile(const Common::Array<uint32> &sorted, uint p) {
+	if (sorted.empty())
+		return 0;
+
+	return sorted[MIN<uint32>((sorted.size() * p) / 100, sorted.size() - 1)];
+}
+
+void printResult(const char *fileName, const Common::String &decoderName, const Options &options, Result &result) {
+	Common::sort(result.frameTimes.begin(), result.frameTimes.end());
+
+	double seconds = result.totalTime / 1000000.0;
+	double fps = seconds > 0 ? result.frames / seconds : 0;
+	uint32 audioMillis = (uint64)result.audioFrames * 1000 / kOutputRate;
+
+	if (options.csv) {
+		printf("%s,%s,%d,%d,%u,%.3f,%.1f,%.3f,%.3f,%.3f,%.3f,%u,%u,%u,%08x\n",
+			fileName, decoderName.c_str(), result.width, result.height, result.frames, seconds, fps,
+			toMillis(percentile(result.frameTimes, 50)), toMillis(percentile(result.frameTimes, 90)),
+			toMillis(percentile(result.frameTimes, 99)), toMillis(percentile(result.frameTimes, 100)),
+			audioMillis, result.lateFrames, getPeakMemory(), result.checksum.get());
+		return;
+	}
+
+	printf("%s: %s, %dx%d, %u frames (%u shown) in %.3f s\n", fileName, decoderName.c_str(),
+		result.width, result.height, result.frames, result.shownFrames, seconds);
+	printf("  speed:       %.1f frames/s\n", fps);
+	printf("  frame time:  p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+		toMillis(percentile(result.frameTimes, 50)), toMillis(percentile(result.frameTimes, 90)),
+		toMillis(percentile(result.frameTimes, 99)), toMillis(percentile(result.frameTimes, 100)));
+	printf("  audio:       %u ms\n", audioMillis);
+	if (options.decodeAhead)
+		printf("  late frames: %u\n", result.lateFrames);
+	if (getPeakMemory())
+		printf("  peak memory: %u KiB (process, including earlier files)\n", getPeakMemory());
+	printf("  checksum:    %08x\n", result.checksum.get());
+}
+
+void printUsage(const char *name) {
+	printf("Usage: %s [options] <file>...\n\n", name);
+	printf("Decodes all frames and audio of each video without a display, and reports\n");
+	printf("the decoding speed, frame time percentiles, peak memory and a checksum.\n");
+	printf("The peak memory is that of the whole process, so it includes the files\n");
+	printf("decoded before; decode one file per run to measure each file.\n\n");
+	printf("Options:\n");
+	printf("  --decoder <name>      Use this decoder instead of guessing from the extension:\n");
+	printf("                        avi, bink, dxa, flic, imd, mpegps, psx, quicktime,\n");
+	printf("                        smacker, theora, vmd\n");
+	printf("  --rgb565              Convert YUV videos to RGB565 instead of RGBA8888\n");
+	printf("  --decode-ahead <n>    Decode up to n frames ahead (see VideoDecoder::setDecodeAhead())\n");
+	printf("  --csv                 Print one comma separated line per file:\n");
+	printf("                        file,decoder,width,height,frames,seconds,fps,p50,p90,p99,max,\n");
+	printf("                        audio_ms,late_frames,process_peak_kib,checksum\n");
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[]) {
+	Options options;
+	options.decoder = 0;
+	options.hasFormat = false;
+	options.decodeAhead = 0;
+	options.csv = false;
+
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "--decoder") && i + 1 < argc) {
+			options.decoder = argv[++i];
+		} else if (!strcmp(argv[i], "--rgb565")) {
+			options.format = Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);
+			options.hasFormat = true;
+		} else if (!strcmp(argv[i], "--decode-ahead") && i + 1 < argc) {
+			options.decodeAhead = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--csv")) {
+			options.csv = true;
+		} else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (i == argc) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	g_bench = new BenchSystem();
+
+	int failed = 0;
+
+	for (; i < argc; i++) {
+		Result result;
+		Common::String decoderName;
+
+		if (benchmarkFile(argv[i], options, result, decoderName))
+			printResult(argv[i], decoderName, options, result);
+		else
+			failed++;
+	}
+
+	delete g_bench;
+
+	return failed ? 1 : 0;
+}
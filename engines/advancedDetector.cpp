@@ -34,6 +34,13 @@
 #include "engines/advancedDetector.h"
 #include "engines/obsolete.h"
 
+namespace {
+
+/** Tell the detection cache which files a directory listing returned */
+void noteDirectoryListing(const Common::FSNode &dir, const Common::FSList &files);
+
+} // End of anonymous namespace
+
 static GameDescriptor toGameDescriptor(const Common::String &engineID, const ADGameDescription &g, const PlainGameDescriptor *sg) {
 	const char *title = 0;
 	const char *extra;
@@ -131,6 +138,7 @@ GameList AdvancedMetaEngine::detectGames(const Common::FSList &fslist) const {
 		return detectedGames;
 
 	// Compose a hashmap of all files in fslist.
+	noteDirectoryListing(fslist.begin()->getParent(), fslist);
 	composeFileHashMap(allFiles, fslist, (_maxScanDepth == 0 ? 1 : _maxScanDepth));
 
 	// Run the detector on this
@@ -347,6 +355,7 @@ void AdvancedMetaEngine::composeFileHashMap(FileMap &allFiles, const Common::FSL
 			if (!file->getChildren(files, Common::FSNode::kListAll))
 				continue;
 
+			noteDirectoryListing(*file, files);
 			composeFileHashMap(allFiles, files, depth - 1);
 		}
 
@@ -360,11 +369,267 @@ void AdvancedMetaEngine::composeFileHashMap(FileMap &allFiles, const Common::FSL
 	}
 }
 
+namespace {
+
+/**
+ * On-disk cache of the file properties computed during detection, shared by
+ * all engines. It lives next to the configuration file, and an entry is only
+ * used while the size and modification time of the file(s) it was computed
+ * from are unchanged, so that rescanning a game library only needs to query
+ * the file system metadata. When the cache is written, entries for files
+ * which are gone from a directory listed during detection are dropped.
+ * Entries in other directories are kept, even if they cannot be reached.
+ */
+class DetectionCache {
+public:
+	DetectionCache() : _loaded(false), _dirty(false) {}
+
+	bool lookup(const Common::String &key, const Common::String &stamp, ADFileProperties &fileProps);
+	void store(const Common::String &key, const Common::FSNode &node, const Common::String &stamp, const ADFileProperties &fileProps);
+	void noteListing(const Common::FSNode &dir, const Common::FSList &files);
+	void flush();
+
+private:
+	struct Entry {
+		Common::String dir; ///< Directory containing path
+		Common::String path; ///< File the entry is dropped with
+		Common::String stamp;
+		ADFileProperties props;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+	typedef Common::HashMap<Common::String, bool> PathSet;
+
+	static Common::FSNode getCacheFile();
+	void load();
+	void prune();
+
+	EntryMap _entries;
+	PathSet _listedDirs;  ///< Directories listed since the last flush
+	PathSet _listedFiles; ///< Their contents
+	bool _loaded;
+	bool _dirty;
+};
+
+const char *const kDetectionCacheHeader = "# detection cache v3";
+
+DetectionCache &getDetectionCache() {
+	static DetectionCache cache;
+	return cache;
+}
+
+void noteDirectoryListing(const Common::FSNode &dir, const Common::FSList &files) {
+	getDetectionCache().noteListing(dir, files);
+}
+
+Common::FSNode DetectionCache::getCacheFile() {
+	// Keep the cache in the same directory as the config file in use, named
+	// after it, e.g. ".scummvmrc-detection.cache" or "scummvm-detection.cache"
+	// for "scummvm.ini". A config file name without a directory is relative
+	// to the working directory, and so is the cache then.
+	Common::FSNode config(ConfMan.getConfigFileName());
+
+	Common::String name = config.getName();
+	const char *ext = strrchr(name.c_str(), '.');
+	if (ext && ext != name.c_str())
+		name = Common::String(name.c_str(), ext);
+	name += "-detection.cache";
+
+	Common::FSNode parent = config.getParent();
+	if (!parent.isDirectory())
+		return Common::FSNode(name);
+
+	return parent.getChild(name);
+}
+
+void DetectionCache::load() {
+	_loaded = true;
+
+	Common::File file;
+	Common::FSNode node = getCacheFile();
+	if (!node.exists() || !file.open(node))
+		return;
+
+	if (file.readLine() != kDetectionCacheHeader) {
+		debug(2, "Ignoring outdated detection cache '%s'", node.getPath().c_str());
+		return;
+	}
+
+	// Each line is "<stamp>\t<size>\t<md5>\t<dir>\t<path>\t<key>". The
+	// paths and the key go last, since they can contain any character but
+	// tabs.
+	while (!file.eos() && !file.err()) {
+		Common::String line = file.readLine();
+		const char *stampEnd = strchr(line.c_str(), '\t');
+		const char *sizeEnd = stampEnd ? strchr(stampEnd + 1, '\t') : 0;
+		const char *md5End = sizeEnd ? strchr(sizeEnd + 1, '\t') : 0;
+		const char *dirEnd = md5End ? strchr(md5End + 1, '\t') : 0;
+		const char *pathEnd = dirEnd ? strchr(dirEnd + 1, '\t') : 0;
+		if (!pathEnd)
+			continue;
+
+		Entry &entry = _entries[Common::String(pathEnd + 1)];
+		entry.dir = Common::String(md5End + 1, dirEnd);
+		entry.path = Common::String(dirEnd + 1, pathEnd);
+		entry.stamp = Common::String(line.c_str(), stampEnd);
+		entry.props.size = atoi(stampEnd + 1);
+		entry.props.md5 = Common::String(sizeEnd + 1, md5End);
+	}
+
+	debug(2, "Loaded %d entries from detection cache '%s'", _entries.size(), node.getPath().c_str());
+}
+
+bool DetectionCache::lookup(const Common::String &key, const Common::String &stamp, ADFileProperties &fileProps) {
+	if (!_loaded)
+		load();
+
+	EntryMap::const_iterator i = _entries.find(key);
+	if (i == _entries.end() || i->_value.stamp != stamp)
+		return false;
+
+	fileProps = i->_value.props;
+	return true;
+}
+
+void DetectionCache::store(const Common::String &key, const Common::FSNode &node, const Common::String &stamp, const ADFileProperties &fileProps) {
+	if (!_loaded)
+		load();
+
+	Entry &entry = _entries[key];
+	entry.dir = node.getParent().getPath();
+	entry.path = node.getPath();
+	entry.stamp = stamp;
+	entry.props = fileProps;
+	_dirty = true;
+}
+
+void DetectionCache::noteListing(const Common::FSNode &dir, const Common::FSList &files) {
+	_listedDirs[dir.getPath()] = true;
+	for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file)
+		_listedFiles[file->getPath()] = true;
+}
+
+void DetectionCache::flush() {
+	prune();
+	if (!_dirty)
+		return;
+
+	_dirty = false;
+
+	Common::FSNode node = getCacheFile();
+	Common::WriteStream *stream = node.createWriteStream();
+	if (!stream) {
+		warning("Unable to write detection cache '%s'", node.getPath().c_str());
+		return;
+	}
+
+	stream->writeString(kDetectionCacheHeader);
+	stream->writeByte('\n');
+
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		stream->writeString(Common::String::format("%s\t%d\t%s\t%s\t%s\t%s\n",
+			i->_value.stamp.c_str(), i->_value.props.size, i->_value.props.md5.c_str(),
+			i->_value.dir.c_str(), i->_value.path.c_str(), i->_key.c_str()));
+	}
+
+	stream->finalize();
+	delete stream;
+}
+
+void DetectionCache::prune() {
+	Common::Array<Common::String> removed;
+
+	// Only look at the directories which were just listed, and so are known
+	// to be reachable. The listings leave out hidden files, so a file which
+	// is missing from one is only dropped once it is confirmed to be gone.
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i)
+		if (_listedDirs.contains(i->_value.dir) && !_listedFiles.contains(i->_value.path) &&
+				!Common::FSNode(i->_value.path).exists())
+			removed.push_back(i->_key);
+
+	for (uint i = 0; i < removed.size(); i++)
+		_entries.erase(removed[i]);
+
+	_listedDirs.clear();
+	_listedFiles.clear();
+
+	if (!removed.empty()) {
+		debug(2, "Dropped %d entries for removed files from the detection cache", removed.size());
+		_dirty = true;
+	}
+}
+
+/**
+ * Describe the size and modification time of a file, for validating cache
+ * entries. Returns an empty string if the backend cannot tell.
+ */
+Common::String getFileStamp(const Common::FSNode &node) {
+	uint64 size;
+	uint32 modificationTime;
+	if (!node.getFileStats(size, modificationTime))
+		return Common::String();
+
+	return Common::String::format("%llu:%u", (unsigned long long)size, modificationTime);
+}
+
+/**
+ * Describe all the files MacResManager may read a resource fork from. Files
+ * that do not exist are part of the stamp as well, so that adding one of
+ * them invalidates the entry. The first file which exists is returned in
+ * firstFile.
+ */
+Common::String getResForkStamp(const Common::FSNode &parent, const Common::String &fname, Common::FSNode &firstFile) {
+	const Common::String candidates[] = {
+		fname,
+		fname + ".rsrc",
+		Common::MacResManager::constructAppleDoubleName(fname),
+		fname + ".bin"
+	};
+
+	Common::String stamp;
+	bool found = false;
+
+	for (int i = 0; i < ARRAYSIZE(candidates); i++) {
+		Common::FSNode node = parent.getChild(candidates[i]);
+		Common::String fileStamp = getFileStamp(node);
+
+		if (fileStamp.empty()) {
+			// Only cache this if we know the file really is missing
+			if (node.exists())
+				return Common::String();
+
+			fileStamp = "-";
+		} else if (!found) {
+			firstFile = node;
+			found = true;
+		}
+
+		if (i != 0)
+			stamp += ',';
+		stamp += fileStamp;
+	}
+
+	return stamp;
+}
+
+} // End of anonymous namespace
+
+void AdvancedMetaEngine::flushDetectionCache() {
+	getDetectionCache().flush();
+}
+
 bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const FileMap &allFiles, const ADGameDescription &game, const Common::String fname, ADFileProperties &fileProps) const {
 	// FIXME/TODO: We don't handle the case that a file is listed as a regular
 	// file and as one with resource fork.
 
 	if (game.flags & ADGF_MACRESFORK) {
+		Common::String key = Common::String::format("r%d:%s/%s", _md5Bytes, parent.getPath().c_str(), fname.c_str());
+		Common::FSNode firstFile;
+		Common::String stamp = getResForkStamp(parent, fname, firstFile);
+
+		if (!stamp.empty() && getDetectionCache().lookup(key, stamp, fileProps))
+			return true;
+
 		Common::MacResManager macResMan;
 
 		if (!macResMan.open(parent, fname))
@@ -372,35 +637,100 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 
 		fileProps.md5 = macResMan.computeResForkMD5AsString(_md5Bytes);
 		fileProps.size = macResMan.getResForkDataSize();
+
+		if (!stamp.empty())
+			getDetectionCache().store(key, firstFile, stamp, fileProps);
 		return true;
 	}
 
 	if (!allFiles.contains(fname))
 		return false;
 
+	const Common::FSNode &node = allFiles[fname];
+	Common::String key = Common::String::format("f%d:%s", _md5Bytes, node.getPath().c_str());
+	Common::String stamp = getFileStamp(node);
+
+	if (!stamp.empty() && getDetectionCache().lookup(key, stamp, fileProps))
+		return true;
+
 	Common::File testFile;
 
-	if (!testFile.open(allFiles[fname]))
+	if (!testFile.open(node))
 		return false;
 
 	fileProps.size = (int32)testFile.size();
 	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+
+	if (!stamp.empty())
+		getDetectionCache().store(key, node, stamp, fileProps);
 	return true;
 }
 
+void AdvancedMetaEngine::buildFileIndex() const {
+	const byte *descPtr;
+	uint i;
+
+	for (i = 0, descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameid != 0; descPtr += _descItemSize, ++i) {
+		const ADGameDescription *g = (const ADGameDescription *)descPtr;
+		uint fileCount = 0;
+
+		for (const ADGameFileDescription *fileDesc = g->filesDescriptions; fileDesc->fileName; fileDesc++) {
+			Common::Array<uint> &descs = _fileIndex[fileDesc->fileName];
+
+			// Entries are visited in order, so this skips duplicate file names
+			// within a single entry
+			if (descs.empty() || descs.back() != i) {
+				descs.push_back(i);
+				fileCount++;
+			}
+		}
+
+		_descFileCounts.push_back(fileCount);
+
+		if (g->flags & ADGF_MACRESFORK)
+			_resForkDescs.push_back(i);
+	}
+
+	_fileIndexBuilt = true;
+}
+
 ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, const FileMap &allFiles, Common::Language language, Common::Platform platform, const Common::String &extra) const {
 	ADFilePropertiesMap filesProps;
 
 	const ADGameFileDescription *fileDesc;
 	const ADGameDescription *g;
-	const byte *descPtr;
 
 	debug(3, "Starting detection in dir '%s'", parent.getPath().c_str());
 
+	if (!_fileIndexBuilt)
+		buildFileIndex();
+
 	// Check which files are included in some ADGameDescription *and* are present.
-	// Compute MD5s and file sizes for these files.
-	for (descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameid != 0; descPtr += _descItemSize) {
-		g = (const ADGameDescription *)descPtr;
+	// Compute MD5s and file sizes for these files. As before, the properties
+	// of a file are taken from the first entry which can provide them.
+	for (FileMap::const_iterator file = allFiles.begin(); file != allFiles.end(); ++file) {
+		FileIndex::const_iterator index = _fileIndex.find(file->_key);
+		if (index == _fileIndex.end())
+			continue;
+
+		const Common::String &fname = index->_key;
+
+		for (uint j = 0; j < index->_value.size(); j++) {
+			ADFileProperties tmp;
+
+			g = getDescription(index->_value[j]);
+			if (getFileProperties(parent, allFiles, *g, fname, tmp)) {
+				debug(3, "> '%s': '%s'", fname.c_str(), tmp.md5.c_str());
+				filesProps[fname] = tmp;
+				break;
+			}
+		}
+	}
+
+	// Resource forks may live in files which are named differently, so try
+	// those entries even when their files are not in the list
+	for (uint j = 0; j < _resForkDescs.size(); j++) {
+		g = getDescription(_resForkDescs[j]);
 
 		for (fileDesc = g->filesDescriptions; fileDesc->fileName; fileDesc++) {
 			Common::String fname = fileDesc->fileName;
@@ -416,14 +746,29 @@ ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, cons
 		}
 	}
 
+	// Only entries for which all files are present can match, so count the
+	// present files of every entry to find those
+	Common::Array<uint> presentFiles;
+	presentFiles.resize(_descFileCounts.size());
+	for (uint j = 0; j < presentFiles.size(); j++)
+		presentFiles[j] = 0;
+
+	for (ADFilePropertiesMap::const_iterator file = filesProps.begin(); file != filesProps.end(); ++file) {
+		FileIndex::const_iterator index = _fileIndex.find(file->_key);
+		for (uint j = 0; j < index->_value.size(); j++)
+			presentFiles[index->_value[j]]++;
+	}
+
 	ADGameDescList matched;
 	int maxFilesMatched = 0;
 	bool gotAnyMatchesWithAllFiles = false;
 
 	// MD5 based matching
-	uint i;
-	for (i = 0, descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameid != 0; descPtr += _descItemSize, ++i) {
-		g = (const ADGameDescription *)descPtr;
+	for (uint i = 0; i < presentFiles.size(); ++i) {
+		if (presentFiles[i] != _descFileCounts[i])
+			continue;
+
+		g = getDescription(i);
 		bool fileMissing = false;
 
 		// Do not even bother to look at entries which do not have matching
@@ -587,6 +932,7 @@ AdvancedMetaEngine::AdvancedMetaEngine(const void *descs, uint descItemSize, con
 	_guioptions = GUIO_NONE;
 	_maxScanDepth = 1;
 	_directoryGlobs = NULL;
+	_fileIndexBuilt = false;
 }
 
 void AdvancedMetaEngine::initSubSystems(const ADGameDescription *gameDesc) const {
@@ -255,6 +255,13 @@ public:
 
 	virtual const ExtraGuiOptions getExtraGuiOptions(const Common::String &target) const;
 
+	/**
+	 * Write the file properties gathered by all engines during detection to
+	 * the on-disk detection cache, if any of them changed. Call this once a
+	 * scan is complete.
+	 */
+	static void flushDetectionCache();
+
 protected:
 	// To be implemented by subclasses
 	virtual bool createInstance(OSystem *syst, Engine **engine, const ADGameDescription *desc) const = 0;
@@ -315,8 +322,36 @@ protected:
 	 */
 	void composeFileHashMap(FileMap &allFiles, const Common::FSList &fslist, int depth) const;
 
-	/** Get the properties (size and MD5) of this file. */
+	/**
+	 * Get the properties (size and MD5) of this file. Results are kept in
+	 * the detection cache, see flushDetectionCache().
+	 */
 	bool getFileProperties(const Common::FSNode &parent, const FileMap &allFiles, const ADGameDescription &game, const Common::String fname, ADFileProperties &fileProps) const;
+
+private:
+	/** Return the entry of _gameDescriptors with the given index. */
+	const ADGameDescription *getDescription(uint index) const {
+		return (const ADGameDescription *)(_gameDescriptors + index * _descItemSize);
+	}
+
+	/**
+	 * Build the index from file names to the entries of _gameDescriptors,
+	 * which lets detectGame() skip all entries whose files are not present.
+	 */
+	void buildFileIndex() const;
+
+	typedef Common::HashMap<Common::String, Common::Array<uint>, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FileIndex;
+
+	/** Map from file names to the indices of the entries using them, in table order. */
+	mutable FileIndex _fileIndex;
+
+	/** The number of distinct file names of each entry. */
+	mutable Common::Array<uint> _descFileCounts;
+
+	/** Indices of the entries using resource forks. */
+	mutable Common::Array<uint> _resForkDescs;
+
+	mutable bool _fileIndexBuilt;
 };
 
 #endif
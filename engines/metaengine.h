@@ -264,7 +264,12 @@ class EngineManager : public Common::Singleton<EngineManager> {
 public:
 	/// Given a list of FSNodes in a given directory, detect a set of games contained within.
 	/// Returns an empty list if none are found.
-	GameList detectGames(const Common::FSList &fslist) const;
+	/// When scanning many directories in a row, pass false for flushCache and call
+	/// flushDetectionCache() once the scan is complete.
+	GameList detectGames(const Common::FSList &fslist, bool flushCache = true) const;
+
+	/// Write the file properties gathered during detection to disk.
+	void flushDetectionCache() const;
 
 	/// Find a plugin by its engine ID.
 	const EnginePlugin *findPlugin(const Common::String &engineID) const;
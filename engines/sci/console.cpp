@@ -97,6 +97,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("selectors",			WRAP_METHOD(Console, cmdSelectors));
 	registerCmd("functions",			WRAP_METHOD(Console, cmdKernelFunctions));
 	registerCmd("class_table",		WRAP_METHOD(Console, cmdClassTable));
+	registerCmd("selector_cache",		WRAP_METHOD(Console, cmdSelectorCache));
 	// Parser
 	registerCmd("suffixes",			WRAP_METHOD(Console, cmdSuffixes));
 	registerCmd("parse_grammar",		WRAP_METHOD(Console, cmdParseGrammar));
@@ -141,6 +142,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("pi",                 WRAP_METHOD(Console, cmdPlaneItemList));	// alias
 	registerCmd("saved_bits",         WRAP_METHOD(Console, cmdSavedBits));
 	registerCmd("show_saved_bits",    WRAP_METHOD(Console, cmdShowSavedBits));
+	registerCmd("view_cache",         WRAP_METHOD(Console, cmdViewCache));
 	// Segments
 	registerCmd("segment_table",		WRAP_METHOD(Console, cmdPrintSegmentTable));
 	registerCmd("segtable",			WRAP_METHOD(Console, cmdPrintSegmentTable));	// alias
@@ -150,6 +152,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("segkill",			WRAP_METHOD(Console, cmdKillSegment));			// alias
 	// Garbage collection
 	registerCmd("gc",					WRAP_METHOD(Console, cmdGCInvoke));
+	registerCmd("gc_stats",				WRAP_METHOD(Console, cmdGCStats));
 	registerCmd("gc_objects",			WRAP_METHOD(Console, cmdGCObjects));
 	registerCmd("gc_reachable",		WRAP_METHOD(Console, cmdGCShowReachable));
 	registerCmd("gc_freeable",		WRAP_METHOD(Console, cmdGCShowFreeable));
@@ -339,6 +342,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" selector - Attempts to find the requested selector by name\n");
 	debugPrintf(" functions - Lists the kernel functions\n");
 	debugPrintf(" class_table - Shows the available classes\n");
+	debugPrintf(" selector_cache - Shows the hit/miss counters of the selector lookup cache\n");
 	debugPrintf("\n");
 	debugPrintf("Parser:\n");
 	debugPrintf(" suffixes - Lists the vocabulary suffixes\n");
@@ -355,7 +359,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" hexdump - Dumps the specified resource to standard output\n");
 	debugPrintf(" resource_id - Identifies a resource number by splitting it up in resource type and resource number\n");
 	debugPrintf(" resource_info - Shows info about a resource\n");
-	debugPrintf(" resource_types - Shows the valid resource types\n");
+	debugPrintf(" resource_types - Shows the valid resource types and resource cache statistics\n");
 	debugPrintf(" list - Lists all the resources of a given type\n");
 	debugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	debugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
@@ -383,6 +387,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" plane_items / pi - Shows a list of all items for a plane (SCI2+)\n");
 	debugPrintf(" saved_bits - List saved bits on the hunk\n");
 	debugPrintf(" show_saved_bits - Display saved bits\n");
+	debugPrintf(" view_cache - Shows the usage and hit/miss/eviction counters of the view cache\n");
 	debugPrintf("\n");
 	debugPrintf("Segments:\n");
 	debugPrintf(" segment_table / segtable - Lists all segments\n");
@@ -391,6 +396,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf("\n");
 	debugPrintf("Garbage collection:\n");
 	debugPrintf(" gc - Invokes the garbage collector\n");
+	debugPrintf(" gc_stats - Shows the number of collections and their pause times\n");
 	debugPrintf(" gc_objects - Lists all reachable objects, normalized\n");
 	debugPrintf(" gc_reachable - Lists all addresses directly reachable from a given memory object\n");
 	debugPrintf(" gc_freeable - Lists all addresses freeable in a given segment\n");
@@ -956,6 +962,13 @@ bool Console::cmdResourceTypes(int argc, const char **argv) {
 		debugPrintf((i < kResourceTypeInvalid - 1) ? ", " : "\n");
 	}
 
+	ResourceManager *resMan = _engine->getResMan();
+	const ResourceCacheStats &stats = resMan->getCacheStats();
+	debugPrintf("\nResource cache: %d KB unlocked of %d KB, %d KB locked\n",
+		resMan->getMemoryLRU() / 1024, resMan->getMaxMemoryLRU() / 1024, resMan->getMemoryLocked() / 1024);
+	debugPrintf("%d hits, %d misses (%d KB loaded), %d evictions\n",
+		stats.hits, stats.misses, stats.loadedBytes / 1024, stats.evictions);
+
 	return true;
 }
 
@@ -1377,6 +1390,13 @@ bool Console::cmdClassTable(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdSelectorCache(int argc, const char **argv) {
+	const SelectorCacheStats &stats = _engine->_gamestate->_segMan->getSelectorCacheStats();
+
+	debugPrintf("Selector cache: %d hits, %d misses, %d flushes\n", stats.hits, stats.misses, stats.flushes);
+	return true;
+}
+
 bool Console::cmdSentenceFragments(int argc, const char **argv) {
 	debugPrintf("Sentence fragments (used to build Parse trees)\n");
 
@@ -1744,6 +1764,11 @@ bool Console::cmdAnimateList(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdViewCache(int argc, const char **argv) {
+	_engine->_gfxCache->printViewCache(this);
+	return true;
+}
+
 bool Console::cmdWindowList(int argc, const char **argv) {
 	if (_engine->_gfxPorts) {
 		debugPrintf("Window list:\n");
@@ -2357,6 +2382,16 @@ bool Console::cmdIsSample(int argc, const char **argv) {
 bool Console::cmdGCInvoke(int argc, const char **argv) {
 	debugPrintf("Performing garbage collection...\n");
 	run_gc(_engine->_gamestate);
+	debugPrintf("Garbage collection took %d ms\n", _engine->_gamestate->gcStats.lastPause);
+	return true;
+}
+
+bool Console::cmdGCStats(int argc, const char **argv) {
+	const GCStats &stats = _engine->_gamestate->gcStats;
+
+	debugPrintf("Garbage collections: %d (%d periodic ones skipped), %d objects freed\n", stats.runs, stats.skipped, stats.freed);
+	debugPrintf("Pause times: last %d ms, longest %d ms, average %d ms\n", stats.lastPause, stats.maxPause,
+	            stats.runs ? stats.totalPause / stats.runs : 0);
 	return true;
 }
 
@@ -22,6 +22,7 @@
 
 #include "sci/engine/gc.h"
 #include "common/array.h"
+#include "common/system.h"
 #include "sci/graphics/ports.h"
 
 namespace Sci {
@@ -162,6 +163,8 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 
 void run_gc(EngineState *s) {
 	SegManager *segMan = s->_segMan;
+	uint32 startTime = g_system->getMillis();
+	uint32 freed = 0;
 
 	// Some debug stuff
 	debugC(kDebugLevelGC, "[GC] Running...");
@@ -195,6 +198,7 @@ void run_gc(EngineState *s) {
 				if (!activeRefs->contains(addr)) {
 					// Not found -> we can free it
 					mobj->freeAtAddress(segMan, addr);
+					freed++;
 					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
 #ifdef GC_DEBUG_CODE
 					segcount[type]++;
@@ -207,6 +211,16 @@ void run_gc(EngineState *s) {
 
 	delete activeRefs;
 
+	segMan->setHeapChangedSinceGC(false);
+
+	GCStats &stats = s->gcStats;
+	stats.runs++;
+	stats.freed += freed;
+	stats.lastPause = g_system->getMillis() - startTime;
+	stats.maxPause = MAX(stats.maxPause, stats.lastPause);
+	stats.totalPause += stats.lastPause;
+	debugC(kDebugLevelGC, "[GC] Freed %d objects in %d ms", freed, stats.lastPause);
+
 #ifdef GC_DEBUG_CODE
 	// Output debug summary of garbage collection
 	debugC(kDebugLevelGC, "[GC] Summary:");
@@ -111,10 +111,24 @@ struct Vertex {
 	// Previous vertex in shortest path
 	Vertex *path_prev;
 
+	// Order in which the vertex entered the A* open set, 0 if it didn't yet
+	uint32 openOrder;
+	bool closed;
+
+	// Index in the visibility cache, -1 for vertices without edges
+	int cacheIndex;
+
+	// Last edge grid query that tested the edge starting at this vertex
+	uint32 gridStamp;
+
 public:
 	Vertex(const Common::Point &p) : v(p) {
 		costG = HUGE_DISTANCE;
 		path_prev = NULL;
+		openOrder = 0;
+		closed = false;
+		cacheIndex = -1;
+		gridStamp = 0;
 	}
 };
 
@@ -236,6 +250,16 @@ public:
 
 typedef Common::List<Polygon *> PolygonList;
 
+// Number of cells along each axis of the edge grid
+#define EDGE_GRID_SIZE 16
+
+// Visibility cache entries
+enum {
+	VIS_UNKNOWN = 0,
+	VIS_VISIBLE = 1,
+	VIS_HIDDEN = 2
+};
+
 // Pathfinding state
 struct PathfindingState {
 	// List of all polygons
@@ -257,6 +281,17 @@ struct PathfindingState {
 	// Screen size
 	int _width, _height;
 
+	// Edges sorted into a grid of cells covering all polygons, indexed by
+	// the vertex the edge starts at
+	Common::Array<Vertex *> _gridCells[EDGE_GRID_SIZE * EDGE_GRID_SIZE];
+	int _gridLeft, _gridTop;
+	int _gridCellWidth, _gridCellHeight;
+	uint32 _gridStamp;
+
+	// Visibility between the vertices with edges, shared between calls
+	Common::Array<byte> *_visibility;
+	int _cachedVertices;
+
 	PathfindingState(int width, int height) : _width(width), _height(height) {
 		vertex_start = NULL;
 		vertex_end = NULL;
@@ -264,6 +299,11 @@ struct PathfindingState {
 		_prependPoint = NULL;
 		_appendPoint = NULL;
 		vertices = 0;
+		_gridLeft = _gridTop = 0;
+		_gridCellWidth = _gridCellHeight = 1;
+		_gridStamp = 0;
+		_visibility = NULL;
+		_cachedVertices = 0;
 	}
 
 	~PathfindingState() {
@@ -280,6 +320,14 @@ struct PathfindingState {
 	bool pointOnScreenBorder(const Common::Point &p);
 	bool edgeOnScreenBorder(const Common::Point &p, const Common::Point &q);
 	int findNearPoint(const Common::Point &p, Polygon *polygon, Common::Point *ret);
+
+	int gridColumn(float x) const {
+		return CLIP<int>((int)floor((x - _gridLeft) / _gridCellWidth), 0, EDGE_GRID_SIZE - 1);
+	}
+
+	int gridRow(float y) const {
+		return CLIP<int>((int)floor((y - _gridTop) / _gridCellHeight), 0, EDGE_GRID_SIZE - 1);
+	}
 };
 
 static Common::Point readPoint(SegmentRef list_r, int offset) {
@@ -659,6 +707,164 @@ static int inside(const Common::Point &p, Vertex *vertex) {
 	return 0;
 }
 
+/**
+ * Sorts the polygon edges into the cells of the edge grid. Each edge is added
+ * to all cells covered by its bounding box.
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ */
+static void build_edge_grid(PathfindingState *s) {
+	int left = 0x7fff, top = 0x7fff, right = -0x8000, bottom = -0x8000;
+
+	for (int i = 0; i < s->vertices; i++) {
+		const Common::Point &p = s->vertex_index[i]->v;
+		left = MIN<int>(left, p.x);
+		top = MIN<int>(top, p.y);
+		right = MAX<int>(right, p.x);
+		bottom = MAX<int>(bottom, p.y);
+	}
+
+	s->_gridLeft = left;
+	s->_gridTop = top;
+	s->_gridCellWidth = (right - left) / EDGE_GRID_SIZE + 1;
+	s->_gridCellHeight = (bottom - top) / EDGE_GRID_SIZE + 1;
+
+	for (int i = 0; i < s->vertices; i++) {
+		Vertex *edge = s->vertex_index[i];
+		if (!VERTEX_HAS_EDGES(edge))
+			continue;
+
+		const Common::Point &p = edge->v;
+		const Common::Point &q = CLIST_NEXT(edge)->v;
+		int col1 = s->gridColumn(MIN(p.x, q.x)), col2 = s->gridColumn(MAX(p.x, q.x));
+		int row1 = s->gridRow(MIN(p.y, q.y)), row2 = s->gridRow(MAX(p.y, q.y));
+
+		for (int row = row1; row <= row2; row++)
+			for (int col = col1; col <= col2; col++)
+				s->_gridCells[row * EDGE_GRID_SIZE + col].push_back(edge);
+	}
+}
+
+/**
+ * Checks whether an edge blocks the line between two vertices
+ * Parameters: (Vertex *) vertex_cur, vertex: The vertices
+ *             (Vertex *) edge: The vertex the edge starts at
+ * Returns   : (bool) true if the line is blocked, false otherwise
+ */
+static bool edge_blocks(Vertex *vertex_cur, Vertex *vertex, Vertex *edge) {
+	if (between(vertex_cur->v, vertex->v, edge->v)) {
+		// If we hit a vertex, make sure we can pass through it without intersecting its polygon
+		// Otherwise this edge won't properly intersect
+		return inside(vertex_cur->v, edge) || inside(vertex->v, edge);
+	}
+
+	return intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v);
+}
+
+/**
+ * Determines whether a vertex is visible from another vertex. Only the edges
+ * in the grid cells the line between them passes through are tested: any edge
+ * that blocks the line shares a point, and thus a cell, with it.
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ *             (Vertex *) vertex_cur, vertex: The vertices
+ * Returns   : (bool) true if the vertices can see each other, false otherwise
+ */
+static bool is_visible(PathfindingState *s, Vertex *vertex_cur, Vertex *vertex) {
+	// Make sure we don't intersect a polygon locally at the vertices
+	if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		return false;
+
+	const Common::Point &a = vertex_cur->v;
+	const Common::Point &b = vertex->v;
+
+	// between() treats all points on the same row as lying on an empty
+	// line, so distinct vertices at the same position check all edges
+	if (a == b) {
+		for (int i = 0; i < s->vertices; i++) {
+			Vertex *edge = s->vertex_index[i];
+			if (VERTEX_HAS_EDGES(edge) && edge_blocks(vertex_cur, vertex, edge))
+				return false;
+		}
+		return true;
+	}
+
+	int top = MIN(a.y, b.y), bottom = MAX(a.y, b.y);
+	int row1 = s->gridRow(top), row2 = s->gridRow(bottom);
+
+	s->_gridStamp++;
+
+	for (int row = row1; row <= row2; row++) {
+		// Find the part of the line that lies within this row, the outer
+		// rows also cover anything beyond the grid
+		float y1 = (row == row1) ? top : s->_gridTop + row * s->_gridCellHeight;
+		float y2 = (row == row2) ? bottom : s->_gridTop + (row + 1) * s->_gridCellHeight;
+		float x1 = a.x, x2 = b.x;
+
+		if (a.y != b.y) {
+			float slope = (float)(b.x - a.x) / (b.y - a.y);
+			x1 = a.x + (y1 - a.y) * slope;
+			x2 = a.x + (y2 - a.y) * slope;
+		}
+
+		// Add a cell on either side to be safe from rounding errors
+		int col1 = MAX(s->gridColumn(MIN(x1, x2)) - 1, 0);
+		int col2 = MIN(s->gridColumn(MAX(x1, x2)) + 1, EDGE_GRID_SIZE - 1);
+
+		for (int col = col1; col <= col2; col++) {
+			const Common::Array<Vertex *> &cell = s->_gridCells[row * EDGE_GRID_SIZE + col];
+
+			for (uint i = 0; i < cell.size(); i++) {
+				Vertex *edge = cell[i];
+				if (edge->gridStamp == s->_gridStamp)
+					continue;
+
+				edge->gridStamp = s->_gridStamp;
+				if (edge_blocks(vertex_cur, vertex, edge))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Prepares the visibility cache for a polygon set. The visibility between
+ * two vertices only depends on the polygon edges, so it is kept as long as
+ * the vertices with edges, and the way they are connected, stay the same.
+ * Parameters: (EngineState *) s: The game state
+ *             (PathfindingState *) p: The pathfinding state
+ */
+static void prepare_visibility_cache(EngineState *s, PathfindingState *p) {
+	AvoidPathCache &cache = s->_avoidPathCache;
+	Common::Array<int16> signature;
+	int count = 0;
+
+	for (int i = 0; i < p->vertices; i++) {
+		Vertex *vertex = p->vertex_index[i];
+		if (VERTEX_HAS_EDGES(vertex))
+			vertex->cacheIndex = count++;
+	}
+
+	for (int i = 0; i < p->vertices; i++) {
+		Vertex *vertex = p->vertex_index[i];
+		if (VERTEX_HAS_EDGES(vertex)) {
+			signature.push_back(vertex->v.x);
+			signature.push_back(vertex->v.y);
+			signature.push_back(CLIST_NEXT(vertex)->cacheIndex);
+		}
+	}
+
+	if (signature != cache.signature) {
+		debugC(kDebugLevelAvoidPath, "[avoidpath] Polygon set changed, visibility cache of %d vertices cleared", count);
+		cache.signature = signature;
+		cache.visibility.clear();
+		cache.visibility.resize(count * count);
+	}
+
+	p->_visibility = &cache.visibility;
+	p->_cachedVertices = count;
+}
+
 /**
  * Returns a list of all vertices that are visible from a particular vertex.
  * @param s				the pathfinding state
@@ -670,31 +876,24 @@ static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
 
 	for (int i = 0; i < s->vertices; i++) {
 		Vertex *vertex = s->vertex_index[i];
+		bool visible;
 
-		// Make sure we don't intersect a polygon locally at the vertices
-		if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
-			continue;
-
-		// Check for intersecting edges
-		int j;
-		for (j = 0; j < s->vertices; j++) {
-			Vertex *edge = s->vertex_index[j];
-			if (VERTEX_HAS_EDGES(edge)) {
-				if (between(vertex_cur->v, vertex->v, edge->v)) {
-					// If we hit a vertex, make sure we can pass through it without intersecting its polygon
-					if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
-						break;
-
-					// This edge won't properly intersect, so we continue
-					continue;
-				}
+		if (s->_visibility && vertex_cur->cacheIndex >= 0 && vertex->cacheIndex >= 0) {
+			byte &entry = (*s->_visibility)[vertex_cur->cacheIndex * s->_cachedVertices + vertex->cacheIndex];
 
-				if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
-					break;
+			if (entry == VIS_UNKNOWN) {
+				visible = is_visible(s, vertex_cur, vertex);
+				// Visibility is symmetric
+				entry = visible ? VIS_VISIBLE : VIS_HIDDEN;
+				(*s->_visibility)[vertex->cacheIndex * s->_cachedVertices + vertex_cur->cacheIndex] = entry;
+			} else {
+				visible = (entry == VIS_VISIBLE);
 			}
+		} else {
+			visible = is_visible(s, vertex_cur, vertex);
 		}
 
-		if (j == s->vertices)
+		if (visible)
 			visVerts->push_front(vertex);
 	}
 
@@ -1302,6 +1501,93 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 	return pf_s;
 }
 
+// Entry in the A* open set
+struct OpenSetEntry {
+	uint32 costF;
+	uint32 order;
+	Vertex *vertex;
+};
+
+/**
+ * Compares two open set entries. Among vertices with the same F cost, the one
+ * most recently added to the open set comes first.
+ * Returns   : (bool) true if a should be taken from the open set before b
+ */
+static bool open_set_before(const OpenSetEntry &a, const OpenSetEntry &b) {
+	if (a.costF != b.costF)
+		return a.costF < b.costF;
+	return a.order > b.order;
+}
+
+/**
+ * Binary min-heap of vertices that still have to be examined by AStar().
+ * Vertices whose cost decreases are added again; outdated entries are
+ * skipped when they come up.
+ */
+class OpenSet {
+public:
+	OpenSet() : _count(0) {}
+
+	bool empty() const { return _heap.empty(); }
+
+	void push(Vertex *vertex) {
+		if (!vertex->openOrder)
+			vertex->openOrder = ++_count;
+
+		OpenSetEntry entry;
+		entry.costF = vertex->costF;
+		entry.order = vertex->openOrder;
+		entry.vertex = vertex;
+
+		uint i = _heap.size();
+		_heap.push_back(entry);
+
+		while (i > 0 && open_set_before(entry, _heap[(i - 1) / 2])) {
+			_heap[i] = _heap[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+		_heap[i] = entry;
+	}
+
+	/**
+	 * Removes the vertex with the lowest F cost from the open set
+	 * Returns   : (Vertex *) The vertex, or NULL if the open set is empty
+	 */
+	Vertex *pop() {
+		while (!_heap.empty()) {
+			OpenSetEntry top = _heap[0];
+			OpenSetEntry last = _heap.back();
+			_heap.pop_back();
+
+			uint size = _heap.size();
+			if (size) {
+				uint i = 0;
+				for (;;) {
+					uint child = i * 2 + 1;
+					if (child >= size)
+						break;
+					if (child + 1 < size && open_set_before(_heap[child + 1], _heap[child]))
+						child++;
+					if (!open_set_before(_heap[child], last))
+						break;
+					_heap[i] = _heap[child];
+					i = child;
+				}
+				_heap[i] = last;
+			}
+
+			if (!top.vertex->closed && top.costF == top.vertex->costF)
+				return top.vertex;
+		}
+
+		return NULL;
+	}
+
+private:
+	Common::Array<OpenSetEntry> _heap;
+	uint32 _count;
+};
+
 /**
  * Computes a shortest path from vertex_start to vertex_end. The caller can
  * construct the resulting path by following the path_prev links from
@@ -1310,40 +1596,32 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
  * Parameters: (PathfindingState *) s: The pathfinding state
  */
 static void AStar(PathfindingState *s) {
-	// Vertices of which the shortest path is known
-	VertexList closedSet;
-
-	// The remaining vertices
-	VertexList openSet;
+	// The vertices that remain to be examined. Vertices of which the
+	// shortest path is known are marked as closed.
+	OpenSet openSet;
+	bool found = false;
 
-	openSet.push_front(s->vertex_start);
 	s->vertex_start->costG = 0;
 	s->vertex_start->costF = (uint32)sqrt((float)s->vertex_start->v.sqrDist(s->vertex_end->v));
+	openSet.push(s->vertex_start);
 
-	while (!openSet.empty()) {
-		// Find vertex in open set with lowest F cost
-		VertexList::iterator vertex_min_it = openSet.end();
-		Vertex *vertex_min = 0;
-		uint32 min = HUGE_DISTANCE;
-
-		for (VertexList::iterator it = openSet.begin(); it != openSet.end(); ++it) {
-			Vertex *vertex = *it;
-			if (vertex->costF < min) {
-				vertex_min_it = it;
-				vertex_min = *vertex_min_it;
-				min = vertex->costF;
-			}
-		}
-
-		assert(vertex_min != 0);	// the vertex cost should never be bigger than HUGE_DISTANCE
+	// WORKAROUND: The screen edge penalty below fails in QFG1VGA, room 81
+	// (bug report #3568452). However, it is needed in other SCI1.1 games,
+	// such as LB2. Therefore, we add this workaround for that scene in
+	// QFG1VGA, until our algorithm matches better what SSCI is doing. With
+	// this workaround, QFG1VGA no longer freezes in that scene.
+	bool qfg1VgaWorkaround = (g_sci->getGameId() == GID_QFG1VGA &&
+							  g_sci->getEngineState()->currentRoomNumber() == 81);
 
+	while (Vertex *vertex_min = openSet.pop()) {
 		// Check if we are done
-		if (vertex_min == s->vertex_end)
+		if (vertex_min == s->vertex_end) {
+			found = true;
 			break;
+		}
 
 		// Move vertex from set open to set closed
-		closedSet.push_front(vertex_min);
-		openSet.erase(vertex_min_it);
+		vertex_min->closed = true;
 
 		VertexList *visVerts = visible_vertices(s, vertex_min);
 
@@ -1351,12 +1629,9 @@ static void AStar(PathfindingState *s) {
 			uint32 new_dist;
 			Vertex *vertex = *it;
 
-			if (closedSet.contains(vertex))
+			if (vertex->closed)
 				continue;
 
-			if (!openSet.contains(vertex))
-				openSet.push_front(vertex);
-
 			new_dist = vertex_min->costG + (uint32)sqrt((float)vertex_min->v.sqrDist(vertex->v));
 
 			// When travelling to a vertex on the screen edge, we
@@ -1366,15 +1641,6 @@ static void AStar(PathfindingState *s) {
 			// other, while we apply a penalty to paths traversing it.
 			// This difference might lead to problems, but none are
 			// known at the time of writing.
-
-			// WORKAROUND: This check fails in QFG1VGA, room 81 (bug report #3568452).
-			// However, it is needed in other SCI1.1 games, such as LB2. Therefore, we
-			// add this workaround for that scene in QFG1VGA, until our algorithm matches
-			// better what SSCI is doing. With this workaround, QFG1VGA no longer freezes
-			// in that scene.
-			bool qfg1VgaWorkaround = (g_sci->getGameId() == GID_QFG1VGA &&
-									  g_sci->getEngineState()->currentRoomNumber() == 81);
-
 			if (s->pointOnScreenBorder(vertex->v) && !qfg1VgaWorkaround)
 				new_dist += 10000;
 
@@ -1382,13 +1648,14 @@ static void AStar(PathfindingState *s) {
 				vertex->costG = new_dist;
 				vertex->costF = vertex->costG + (uint32)sqrt((float)vertex->v.sqrDist(s->vertex_end->v));
 				vertex->path_prev = vertex_min;
+				openSet.push(vertex);
 			}
 		}
 
 		delete visVerts;
 	}
 
-	if (openSet.empty())
+	if (!found)
 		debugC(kDebugLevelAvoidPath, "AvoidPath: End point (%i, %i) is unreachable", s->vertex_end->v.x, s->vertex_end->v.y);
 }
 
@@ -1563,6 +1830,9 @@ reg_t kAvoidPath(EngineState *s, int argc, reg_t *argv) {
 			return output;
 		}
 
+		build_edge_grid(p);
+		prepare_visibility_cache(s, p);
+
 		// Apply Dijkstra
 		AStar(p);
 
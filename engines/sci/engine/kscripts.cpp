@@ -192,8 +192,10 @@ reg_t kDisposeClone(EngineState *s, int argc, reg_t *argv) {
 	//  and call kDisposeClone later. In that case we may not free it, otherwise we will run into issues
 	//  later, because kIsObject would then return false and Sound object wouldn't get checked.
 	uint16 infoSelector = object->getInfoSelector().getOffset();
-	if ((infoSelector & 3) == kInfoFlagClone)
+	if ((infoSelector & 3) == kInfoFlagClone) {
 		object->markAsFreed();
+		s->_segMan->setHeapChangedSinceGC(true);
+	}
 
 	return s->r_acc;
 }
@@ -45,6 +45,12 @@ SegManager::SegManager(ResourceManager *resMan, ScriptPatcher *scriptPatcher)
 	_stringSegId = 0;
 #endif
 
+	_heapChangedSinceGC = false;
+
+	_selectorCacheStats.hits = 0;
+	_selectorCacheStats.misses = 0;
+	_selectorCacheStats.flushes = 0;
+
 	createClassTable();
 }
 
@@ -77,6 +83,8 @@ void SegManager::resetSegMan() {
 	// Reinitialize class table
 	_classTable.clear();
 	createClassTable();
+
+	flushSelectorCache();
 }
 
 void SegManager::initSysStrings() {
@@ -117,6 +125,8 @@ SegmentObj *SegManager::allocSegment(SegmentObj *mem, SegmentId *segid) {
 	if (!mem)
 		error("SegManager: invalid mobj");
 
+	_heapChangedSinceGC = true;
+
 	// ... and put it into the (formerly) free segment.
 	if (id >= (int)_heap.size()) {
 		assert(id == (int)_heap.size());
@@ -154,6 +164,7 @@ void SegManager::deallocate(SegmentId seg) {
 
 	if (mobj->getType() == SEG_TYPE_SCRIPT) {
 		Script *scr = (Script *)mobj;
+		flushSelectorCache();
 		_scriptSegMap.erase(scr->getScriptNumber());
 		if (scr->getLocalsSegment()) {
 			// Check if the locals segment has already been deallocated.
@@ -184,6 +195,36 @@ void SegManager::deallocateScript(int script_nr) {
 	deallocate(getScriptSegment(script_nr));
 }
 
+const SelectorCacheEntry *SegManager::getCachedSelector(reg_t classPos, Selector selector) {
+	SelectorCacheKey key;
+	key.classPos = classPos;
+	key.selector = selector;
+
+	SelectorCache::const_iterator it = _selectorCache.find(key);
+	if (it == _selectorCache.end()) {
+		_selectorCacheStats.misses++;
+		return NULL;
+	}
+
+	_selectorCacheStats.hits++;
+	return &it->_value;
+}
+
+void SegManager::cacheSelector(reg_t classPos, Selector selector, const SelectorCacheEntry &entry) {
+	SelectorCacheKey key;
+	key.classPos = classPos;
+	key.selector = selector;
+	_selectorCache[key] = entry;
+}
+
+void SegManager::flushSelectorCache() {
+	if (_selectorCache.empty())
+		return;
+
+	_selectorCache.clear();
+	_selectorCacheStats.flushes++;
+}
+
 Script *SegManager::getScript(const SegmentId seg) {
 	if (seg < 1 || (uint)seg >= _heap.size()) {
 		error("SegManager::getScript(): seg id %x out of bounds", seg);
@@ -387,6 +428,7 @@ reg_t SegManager::allocateHunkEntry(const char *hunk_type, int size) {
 	table = (HunkTable *)_heap[_hunksSegId];
 
 	offset = table->allocEntry();
+	_heapChangedSinceGC = true;
 
 	reg_t addr = make_reg(_hunksSegId, offset);
 	Hunk *h = &(table->_table[offset]);
@@ -422,6 +464,7 @@ Clone *SegManager::allocateClone(reg_t *addr) {
 		table = (CloneTable *)_heap[_clonesSegId];
 
 	offset = table->allocEntry();
+	_heapChangedSinceGC = true;
 
 	*addr = make_reg(_clonesSegId, offset);
 	return &(table->_table[offset]);
@@ -436,6 +479,7 @@ List *SegManager::allocateList(reg_t *addr) {
 	table = (ListTable *)_heap[_listsSegId];
 
 	offset = table->allocEntry();
+	_heapChangedSinceGC = true;
 
 	*addr = make_reg(_listsSegId, offset);
 	return &(table->_table[offset]);
@@ -450,6 +494,7 @@ Node *SegManager::allocateNode(reg_t *addr) {
 	table = (NodeTable *)_heap[_nodesSegId];
 
 	offset = table->allocEntry();
+	_heapChangedSinceGC = true;
 
 	*addr = make_reg(_nodesSegId, offset);
 	return &(table->_table[offset]);
@@ -853,6 +898,7 @@ SciArray<reg_t> *SegManager::allocateArray(reg_t *addr) {
 		table = (ArrayTable *)_heap[_arraysSegId];
 
 	offset = table->allocEntry();
+	_heapChangedSinceGC = true;
 
 	*addr = make_reg(_arraysSegId, offset);
 	return &(table->_table[offset]);
@@ -893,6 +939,7 @@ SciString *SegManager::allocateString(reg_t *addr) {
 		table = (StringTable *)_heap[_stringSegId];
 
 	offset = table->allocEntry();
+	_heapChangedSinceGC = true;
 
 	*addr = make_reg(_stringSegId, offset);
 	return &(table->_table[offset]);
@@ -982,6 +1029,8 @@ int SegManager::instantiateScript(int scriptNum) {
 		scr = allocateScript(scriptNum, &segmentId);
 	}
 
+	flushSelectorCache();
+
 	scr->load(scriptNum, _resMan, _scriptPatcher);
 	scr->initializeLocals(this);
 	scr->initializeClasses(this);
@@ -1017,6 +1066,8 @@ void SegManager::uninstantiateScript(int script_nr) {
 	if (!scr->getLockers()) {
 		// The actual script deletion seems to be done by SCI scripts themselves
 		scr->markDeleted();
+		_heapChangedSinceGC = true;
+		flushSelectorCache();
 		debugC(kDebugLevelScripts, "Unloaded script 0x%x.", script_nr);
 	}
 }
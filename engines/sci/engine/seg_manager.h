@@ -43,6 +43,41 @@ enum ScriptLoadType {
 
 class Script;
 
+/**
+ * Key of the selector lookup cache: a class object and one of its selectors.
+ */
+struct SelectorCacheKey {
+	reg_t classPos;
+	Selector selector;
+
+	bool operator==(const SelectorCacheKey &other) const {
+		return classPos == other.classPos && selector == other.selector;
+	}
+};
+
+struct SelectorCacheKey_Hash {
+	uint operator()(const SelectorCacheKey &x) const {
+		return (x.classPos.getSegment() << 3) ^ x.classPos.getOffset() ^ (x.selector << 16);
+	}
+};
+
+/**
+ * Cached result of looking up a selector in a class: the index of the
+ * variable, or the address of the method found in the class or one of its
+ * superclasses.
+ */
+struct SelectorCacheEntry {
+	SelectorType type;
+	int varIndex;
+	reg_t funcp;
+};
+
+struct SelectorCacheStats {
+	uint32 hits;
+	uint32 misses;
+	uint32 flushes;
+};
+
 class SegManager : public Common::Serializable {
 	friend class Console;
 public:
@@ -441,6 +476,32 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	/**
+	 * Looks up the cached result of a selector lookup in a class.
+	 * @param classPos	the class object
+	 * @param selector	the selector to look up
+	 * @return the cached entry, or NULL if the lookup isn't cached yet
+	 */
+	const SelectorCacheEntry *getCachedSelector(reg_t classPos, Selector selector);
+
+	/**
+	 * Stores the result of a selector lookup in a class. The cache is
+	 * flushed whenever a script is loaded or unloaded, as that may move
+	 * classes and methods around.
+	 */
+	void cacheSelector(reg_t classPos, Selector selector, const SelectorCacheEntry &entry);
+
+	void flushSelectorCache();
+	const SelectorCacheStats &getSelectorCacheStats() const { return _selectorCacheStats; }
+
+	/**
+	 * Returns true if anything the garbage collector could free has been
+	 * allocated or released since the last collection. If not, a periodic
+	 * collection can't shrink the heap and may be skipped.
+	 */
+	bool heapChangedSinceGC() const { return _heapChangedSinceGC; }
+	void setHeapChangedSinceGC(bool changed) { _heapChangedSinceGC = changed; }
+
 private:
 	Common::Array<SegmentObj *> _heap;
 	Common::Array<Class> _classTable; /**< Table of all classes */
@@ -464,6 +525,12 @@ private:
 	SegmentId _stringSegId;
 #endif
 
+	typedef Common::HashMap<SelectorCacheKey, SelectorCacheEntry, SelectorCacheKey_Hash> SelectorCache;
+	SelectorCache _selectorCache;
+	SelectorCacheStats _selectorCacheStats;
+
+	bool _heapChangedSinceGC;
+
 public:
 	SegmentObj *allocSegment(SegmentObj *mem, SegmentId *segid);
 
@@ -250,9 +250,37 @@ void invokeSelector(EngineState *s, reg_t object, int selectorId,
 	run_vm(s); // Start a new vm
 }
 
+/**
+ * Looks up a selector in a class, starting the method search at the class
+ * itself. Used to fill the selector cache of the segment manager.
+ */
+static SelectorCacheEntry lookupClassSelector(SegManager *segMan, const Object *obj, const Object *classObj, Selector selectorId) {
+	SelectorCacheEntry entry;
+	entry.type = kSelectorNone;
+	entry.varIndex = obj->locateVarSelector(segMan, selectorId);
+	entry.funcp = NULL_REG;
+
+	if (entry.varIndex >= 0) {
+		entry.type = kSelectorVariable;
+		return entry;
+	}
+
+	// Check if it's a method, with recursive lookup in superclasses
+	while (classObj) {
+		int index = classObj->funcSelectorPosition(selectorId);
+		if (index >= 0) {
+			entry.type = kSelectorMethod;
+			entry.funcp = classObj->getFunction(index);
+			break;
+		}
+		classObj = segMan->getObject(classObj->getSuperClassSelector());
+	}
+
+	return entry;
+}
+
 SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector selectorId, ObjVarRef *varp, reg_t *fptr) {
 	const Object *obj = segMan->getObject(obj_location);
-	int index;
 	bool oldScriptHeader = (getSciVersion() == SCI_VERSION_0_EARLY);
 
 	// Early SCI versions used the LSB in the selector ID as a read/write
@@ -265,34 +293,52 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector sel
 				PRINT_REG(obj_location));
 	}
 
-	index = obj->locateVarSelector(segMan, selectorId);
-
-	if (index >= 0) {
-		// Found it as a variable
-		if (varp) {
-			varp->obj = obj_location;
-			varp->varindex = index;
+	// The variable selectors of an object are those of its class, and after
+	// the methods of the object itself, its methods are looked up in its
+	// class and the superclasses of that. The result of that lookup is the
+	// same for all instances and clones of a class, so it is cached per
+	// class. SCI3 objects carry their own variable selectors, and clones of
+	// clones have no class to key on: these are always looked up directly.
+	const Object *classObj = obj->getClass(segMan);
+	bool useCache = getSciVersion() <= SCI_VERSION_2_1 && classObj && classObj->isClass();
+	if (useCache && getSciVersion() <= SCI_VERSION_1_LATE && obj->getVarCount() != classObj->getVarCount())
+		useCache = false;
+
+	SelectorCacheEntry entry;
+	if (useCache) {
+		const SelectorCacheEntry *cached = segMan->getCachedSelector(classObj->getPos(), selectorId);
+		if (cached) {
+			entry = *cached;
+		} else {
+			entry = lookupClassSelector(segMan, classObj, classObj, selectorId);
+			segMan->cacheSelector(classObj->getPos(), selectorId, entry);
 		}
-		return kSelectorVariable;
-	} else {
-		// Check if it's a method, with recursive lookup in superclasses
-		while (obj) {
-			index = obj->funcSelectorPosition(selectorId);
-			if (index >= 0) {
-				if (fptr)
-					*fptr = obj->getFunction(index);
 
-				return kSelectorMethod;
-			} else {
-				obj = segMan->getObject(obj->getSuperClassSelector());
+		// Instances may define methods of their own, which take precedence
+		// over those of their class
+		if (entry.type != kSelectorVariable && obj != classObj) {
+			int index = obj->funcSelectorPosition(selectorId);
+			if (index >= 0) {
+				entry.type = kSelectorMethod;
+				entry.funcp = obj->getFunction(index);
 			}
 		}
-
-		return kSelectorNone;
+	} else {
+		entry = lookupClassSelector(segMan, obj, obj, selectorId);
 	}
 
+	if (entry.type == kSelectorVariable) {
+		// Found it as a variable
+		if (varp) {
+			varp->obj = obj_location;
+			varp->varindex = entry.varIndex;
+		}
+	} else if (entry.type == kSelectorMethod) {
+		if (fptr)
+			*fptr = entry.funcp;
+	}
 
-//	return _lookupSelector_function(segMan, obj, selectorId, fptr);
+	return entry.type;
 }
 
 } // End of namespace Sci
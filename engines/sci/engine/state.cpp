@@ -108,6 +108,7 @@ void EngineState::reset(bool isRestoring) {
 	lastWaitTime = 0;
 
 	gcCountDown = 0;
+	gcStats.reset();
 
 	_throttleCounter = 0;
 	_throttleLastTime = 0;
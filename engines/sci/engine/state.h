@@ -95,6 +95,30 @@ struct VideoState {
 	}
 };
 
+/**
+ * Visibility between the polygon vertices of the last polygon set kAvoidPath
+ * worked on. It is reused for as long as the scripts pass the same polygons.
+ */
+struct AvoidPathCache {
+	Common::Array<int16> signature; /**< Position and successor of every polygon vertex */
+	Common::Array<byte> visibility; /**< Visibility of every pair of polygon vertices, 0 if not known yet */
+};
+
+/** Counters of the garbage collector, shown by the gc_stats console command */
+struct GCStats {
+	uint32 runs; /**< Number of collections */
+	uint32 skipped; /**< Number of periodic collections skipped as unneeded */
+	uint32 freed; /**< Total number of freed objects */
+	uint32 lastPause; /**< Duration of the last collection, in ms */
+	uint32 maxPause; /**< Longest collection, in ms */
+	uint32 totalPause; /**< Total time spent collecting, in ms */
+
+	void reset() {
+		runs = skipped = freed = 0;
+		lastPause = maxPause = totalPause = 0;
+	}
+};
+
 struct EngineState : public Common::Serializable {
 public:
 	EngineState(SegManager *segMan);
@@ -188,6 +212,7 @@ public:
 	void shrinkStackToBase();
 
 	int gcCountDown; /**< Number of kernel calls until next gc */
+	GCStats gcStats;
 
 	MessageState *_msgState;
 
@@ -200,6 +225,7 @@ public:
 	byte _memorySegment[kMemorySegmentMax];
 
 	VideoState _videoState;
+	AvoidPathCache _avoidPathCache;
 	uint16 _vmdPalStart, _vmdPalEnd;
 	bool _syncedAudioOptions;
 
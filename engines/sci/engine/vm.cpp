@@ -854,7 +854,10 @@ void run_vm(EngineState *s) {
 			// Run the garbage collector, if needed
 			if (s->gcCountDown-- <= 0) {
 				s->gcCountDown = s->scriptGCInterval;
-				run_gc(s);
+				if (s->_segMan->heapChangedSinceGC())
+					run_gc(s);
+				else
+					s->gcStats.skipped++;
 			}
 
 			// Call kernel function
@@ -135,6 +135,9 @@ void GfxAnimate::makeSortedList(List *list) {
 	_list.clear();
 	_lastCastData.clear();
 
+	// Keep the views of the list in the cache while it is drawn
+	Common::Array<GuiResourceId> viewIds;
+
 	// Fill the list
 	for (listNr = 0; curNode != 0; listNr++) {
 		AnimateEntry listEntry;
@@ -172,11 +175,14 @@ void GfxAnimate::makeSortedList(List *list) {
 		listEntry.showBitsFlag = false;
 
 		_list.push_back(listEntry);
+		viewIds.push_back(listEntry.viewId);
 
 		curAddress = curNode->succ;
 		curNode = _s->_segMan->lookupNode(curAddress);
 	}
 
+	_cache->setPinnedViews(viewIds);
+
 	// Possible TODO: As noted in the comment in sortHelper we actually
 	// require a stable sorting algorithm here. Since Common::sort is not stable
 	// at the time of writing this comment, we work around that in our ordering
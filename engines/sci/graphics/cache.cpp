@@ -25,6 +25,7 @@
 #include "graphics/primitives.h"
 
 #include "sci/sci.h"
+#include "sci/console.h"
 #include "sci/engine/state.h"
 #include "sci/engine/selector.h"
 #include "sci/graphics/cache.h"
@@ -35,7 +36,8 @@
 namespace Sci {
 
 GfxCache::GfxCache(ResourceManager *resMan, GfxScreen *screen, GfxPalette *palette)
-	: _resMan(resMan), _screen(screen), _palette(palette) {
+	: _resMan(resMan), _screen(screen), _palette(palette), _useCounter(0), _frameCounter(0) {
+	memset(&_viewStats, 0, sizeof(_viewStats));
 }
 
 GfxCache::~GfxCache() {
@@ -45,8 +47,8 @@ GfxCache::~GfxCache() {
 
 void GfxCache::purgeFontCache() {
 	for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.font;
+		iter->_value.font = 0;
 	}
 
 	_cachedFonts.clear();
@@ -54,36 +56,146 @@ void GfxCache::purgeFontCache() {
 
 void GfxCache::purgeViewCache() {
 	for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.view;
+		iter->_value.view = 0;
 	}
 
 	_cachedViews.clear();
 }
 
+void GfxCache::evictFont() {
+	FontCache::iterator victim = _cachedFonts.end();
+
+	for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
+		if (victim == _cachedFonts.end() || iter->_value.lastUse < victim->_value.lastUse)
+			victim = iter;
+	}
+
+	if (victim != _cachedFonts.end()) {
+		delete victim->_value.font;
+		_cachedFonts.erase(victim);
+	}
+}
+
+void GfxCache::evictViews(uint32 newViewSize) {
+	// Views decode their cels lazily, so their sizes are only refreshed here
+	uint32 totalSize = newViewSize;
+	uint32 protectedSize = 0;
+	for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
+		CachedView &entry = iter->_value;
+		entry.size = entry.view->getMemorySize();
+		totalSize += entry.size;
+		if (entry.frameCount > 1)
+			protectedSize += entry.size;
+	}
+
+	while (totalSize > MAX_CACHED_VIEWS_SIZE) {
+		// Evict the least recently used view which has only been used in a
+		// single frame. Views used in several frames are protected, as long
+		// as they do not take up more than 3/4 of the budget.
+		ViewCache::iterator probation = _cachedViews.end();
+		ViewCache::iterator protect = _cachedViews.end();
+
+		for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
+			if (_pinnedViews.contains(iter->_key))
+				continue;
+
+			ViewCache::iterator &candidate = (iter->_value.frameCount > 1) ? protect : probation;
+			if (candidate == _cachedViews.end() || iter->_value.lastUse < candidate->_value.lastUse)
+				candidate = iter;
+		}
+
+		ViewCache::iterator victim = probation;
+		if (victim == _cachedViews.end() || (protect != _cachedViews.end() && protectedSize > MAX_CACHED_VIEWS_SIZE / 4 * 3))
+			victim = protect;
+
+		// Everything left is pinned
+		if (victim == _cachedViews.end())
+			break;
+
+		totalSize -= victim->_value.size;
+		if (victim->_value.frameCount > 1)
+			protectedSize -= victim->_value.size;
+
+		delete victim->_value.view;
+		_cachedViews.erase(victim);
+		_viewStats.evictions++;
+	}
+}
+
 GfxFont *GfxCache::getFont(GuiResourceId fontId) {
-	if (_cachedFonts.size() >= MAX_CACHED_FONTS)
-		purgeFontCache();
-
-	if (!_cachedFonts.contains(fontId)) {
-		// Create special SJIS font in japanese games, when font 900 is selected
-		if ((fontId == 900) && (g_sci->getLanguage() == Common::JA_JPN))
-			_cachedFonts[fontId] = new GfxFontSjis(_screen, fontId);
-		else
-			_cachedFonts[fontId] = new GfxFontFromResource(_resMan, _screen, fontId);
+	_useCounter++;
+
+	FontCache::iterator iter = _cachedFonts.find(fontId);
+	if (iter != _cachedFonts.end()) {
+		iter->_value.lastUse = _useCounter;
+		return iter->_value.font;
 	}
 
-	return _cachedFonts[fontId];
+	if (_cachedFonts.size() >= MAX_CACHED_FONTS)
+		evictFont();
+
+	CachedFont entry;
+	// Create special SJIS font in japanese games, when font 900 is selected
+	if ((fontId == 900) && (g_sci->getLanguage() == Common::JA_JPN))
+		entry.font = new GfxFontSjis(_screen, fontId);
+	else
+		entry.font = new GfxFontFromResource(_resMan, _screen, fontId);
+	entry.lastUse = _useCounter;
+	_cachedFonts[fontId] = entry;
+
+	return entry.font;
 }
 
 GfxView *GfxCache::getView(GuiResourceId viewId) {
-	if (_cachedViews.size() >= MAX_CACHED_VIEWS)
-		purgeViewCache();
+	_useCounter++;
+
+	ViewCache::iterator iter = _cachedViews.find(viewId);
+	if (iter != _cachedViews.end()) {
+		CachedView &entry = iter->_value;
+		entry.lastUse = _useCounter;
+		if (entry.lastFrame != _frameCounter) {
+			entry.lastFrame = _frameCounter;
+			entry.frameCount++;
+		}
+		_viewStats.hits++;
+		return entry.view;
+	}
+
+	_viewStats.misses++;
+
+	CachedView entry;
+	entry.view = new GfxView(_resMan, _screen, _palette, viewId);
+	entry.lastUse = _useCounter;
+	entry.lastFrame = _frameCounter;
+	entry.frameCount = 1;
+	entry.size = entry.view->getMemorySize();
+
+	// Make room before adding the new view, so that it is not evicted itself
+	evictViews(entry.size);
+	_cachedViews[viewId] = entry;
+
+	return entry.view;
+}
+
+void GfxCache::setPinnedViews(const Common::Array<GuiResourceId> &viewIds) {
+	_frameCounter++;
+
+	_pinnedViews.clear();
+	for (uint i = 0; i < viewIds.size(); i++)
+		_pinnedViews[viewIds[i]] = true;
+}
 
-	if (!_cachedViews.contains(viewId))
-		_cachedViews[viewId] = new GfxView(_resMan, _screen, _palette, viewId);
+void GfxCache::printViewCache(Console *con) const {
+	uint32 totalSize = 0;
+	for (ViewCache::const_iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter)
+		totalSize += iter->_value.view->getMemorySize();
 
-	return _cachedViews[viewId];
+	con->debugPrintf("%d views cached, %d KB of %d KB, %d views pinned\n",
+		_cachedViews.size(), totalSize / 1024, MAX_CACHED_VIEWS_SIZE / 1024, _pinnedViews.size());
+	con->debugPrintf("%d hits, %d misses, %d evictions\n",
+		_viewStats.hits, _viewStats.misses, _viewStats.evictions);
+	con->debugPrintf("%d fonts cached\n", _cachedFonts.size());
 }
 
 int16 GfxCache::kernelViewGetCelWidth(GuiResourceId viewId, int16 loopNo, int16 celNo) {
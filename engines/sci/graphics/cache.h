@@ -23,18 +23,48 @@
 #ifndef SCI_GRAPHICS_CACHE_H
 #define SCI_GRAPHICS_CACHE_H
 
+#include "common/array.h"
 #include "common/hashmap.h"
 
 namespace Sci {
 
+class Console;
 class GfxFont;
 class GfxView;
 
-typedef Common::HashMap<int, GfxFont *> FontCache;
-typedef Common::HashMap<int, GfxView *> ViewCache;
+struct CachedFont {
+	GfxFont *font;
+	uint32 lastUse;
+};
+
+struct CachedView {
+	GfxView *view;
+	uint32 lastUse;
+	/** The frame in which the view was last used */
+	uint32 lastFrame;
+	/** The number of distinct frames in which the view was used */
+	uint32 frameCount;
+	/** Memory size, as of the last eviction pass */
+	uint32 size;
+};
+
+typedef Common::HashMap<int, CachedFont> FontCache;
+typedef Common::HashMap<int, CachedView> ViewCache;
+
+struct ViewCacheStats {
+	uint32 hits;
+	uint32 misses;
+	uint32 evictions;
+};
 
 /**
  * Cache class, handles caching of views/fonts
+ *
+ * Views are kept within a memory budget (MAX_CACHED_VIEWS_SIZE). When a newly
+ * loaded view exceeds it, the least recently used views are evicted, views
+ * which have been used in a single frame only going first, so that views
+ * which only showed up briefly do not push out the ones used all the time.
+ * Views in the current draw list are pinned and never evicted.
  */
 class GfxCache {
 public:
@@ -44,6 +74,16 @@ public:
 	GfxFont *getFont(GuiResourceId fontId);
 	GfxView *getView(GuiResourceId viewId);
 
+	/**
+	 * Sets the views of the current draw list (kAnimate in SCI0-SCI1.1,
+	 * kFrameout in SCI2+). These are not evicted until the next call,
+	 * which also marks the start of a new frame.
+	 */
+	void setPinnedViews(const Common::Array<GuiResourceId> &viewIds);
+
+	const ViewCacheStats &getViewCacheStats() const { return _viewStats; }
+	void printViewCache(Console *con) const;
+
 	int16 kernelViewGetCelWidth(GuiResourceId viewId, int16 loopNo, int16 celNo);
 	int16 kernelViewGetCelHeight(GuiResourceId viewId, int16 loopNo, int16 celNo);
 	int16 kernelViewGetLoopCount(GuiResourceId viewId);
@@ -54,6 +94,8 @@ public:
 private:
 	void purgeFontCache();
 	void purgeViewCache();
+	void evictFont();
+	void evictViews(uint32 newViewSize);
 
 	ResourceManager *_resMan;
 	GfxScreen *_screen;
@@ -61,6 +103,11 @@ private:
 
 	FontCache _cachedFonts;
 	ViewCache _cachedViews;
+
+	Common::HashMap<int, bool> _pinnedViews;
+	uint32 _useCounter;
+	uint32 _frameCounter;
+	ViewCacheStats _viewStats;
 };
 
 } // End of namespace Sci
@@ -661,6 +661,14 @@ void GfxFrameout::kernelFrameout() {
 
 	_palette->palVaryUpdate();
 
+	// Keep the views of all screen items in the cache while they are drawn
+	Common::Array<GuiResourceId> viewIds;
+	for (FrameoutList::iterator it = _screenItems.begin(); it != _screenItems.end(); ++it) {
+		if ((*it)->viewId != 0xFFFF)
+			viewIds.push_back((*it)->viewId);
+	}
+	_cache->setPinnedViews(viewIds);
+
 	for (PlaneList::iterator it = _planes.begin(); it != _planes.end(); it++) {
 		reg_t planeObject = it->object;
 
@@ -435,6 +435,21 @@ GuiResourceId GfxView::getResourceId() const {
 	return _resourceId;
 }
 
+uint32 GfxView::getMemorySize() const {
+	uint32 size = sizeof(GfxView) + _resourceSize + _loopCount * sizeof(LoopInfo);
+
+	for (uint16 loopNo = 0; loopNo < _loopCount; loopNo++) {
+		size += _loop[loopNo].celCount * sizeof(CelInfo);
+		for (uint16 celNo = 0; celNo < _loop[loopNo].celCount; celNo++) {
+			const CelInfo &cel = _loop[loopNo].cel[celNo];
+			if (cel.rawBitmap)
+				size += cel.width * cel.height;
+		}
+	}
+
+	return size;
+}
+
 int16 GfxView::getWidth(int16 loopNo, int16 celNo) const {
 	return _loopCount ? getCelInfo(loopNo, celNo)->width : 0;
 }
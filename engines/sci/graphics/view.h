@@ -87,6 +87,12 @@ public:
 
 	byte getColorAtCoordinate(int16 loopNo, int16 celNo, int16 x, int16 y);
 
+	/**
+	 * Returns the memory held by this view: the locked resource, the loop
+	 * and cel tables and all cel bitmaps decoded so far.
+	 */
+	uint32 getMemorySize() const;
+
 private:
 	void initData(GuiResourceId resourceId);
 	void unpackCel(int16 loopNo, int16 celNo, byte *outPtr, uint32 pixelCount);
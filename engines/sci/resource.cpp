@@ -22,9 +22,11 @@
 
 // Resource library
 
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
+#include "common/memstream.h"
 #include "common/textconsole.h"
 
 #include "sci/resource.h"
@@ -861,9 +863,11 @@ ResourceManager::ResourceManager() {
 }
 
 void ResourceManager::init() {
+	_maxMemoryLRU = MAX_MEMORY_DETECTION;
 	_memoryLocked = 0;
 	_memoryLRU = 0;
 	_LRU.clear();
+	memset(&_cacheStats, 0, sizeof(_cacheStats));
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 
@@ -914,6 +918,8 @@ void ResourceManager::init() {
 
 	debugC(1, kDebugLevelResMan, "resMan: Detected %s", getSciVersionDesc(getSciVersion()));
 
+	initMaxMemory();
+
 	switch (_viewType) {
 	case kViewEga:
 		debugC(1, kDebugLevelResMan, "resMan: Detected EGA graphic resources");
@@ -947,9 +953,11 @@ void ResourceManager::init() {
 void ResourceManager::initForDetection() {
 	assert(!g_sci);
 
+	_maxMemoryLRU = MAX_MEMORY_DETECTION;
 	_memoryLocked = 0;
 	_memoryLRU = 0;
 	_LRU.clear();
+	memset(&_cacheStats, 0, sizeof(_cacheStats));
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 
@@ -1018,12 +1026,30 @@ void ResourceManager::printLRU() {
 	debug("Total: %d entries, %d bytes (mgr says %d)", entries, mem, _memoryLRU);
 }
 
+void ResourceManager::initMaxMemory() {
+	if (ConfMan.hasKey("sci_resource_cache_size") && ConfMan.getInt("sci_resource_cache_size") > 0) {
+		_maxMemoryLRU = ConfMan.getInt("sci_resource_cache_size") * 1024;
+	} else if (getSciVersion() >= SCI_VERSION_2) {
+		// SCI32 games come with hi-res views and pictures and several
+		// hundred MB of data
+		_maxMemoryLRU = 32 * 1024 * 1024;
+	} else if (getSciVersion() >= SCI_VERSION_1_1) {
+		_maxMemoryLRU = 8 * 1024 * 1024;
+	} else {
+		// Big enough to hold most of an EGA/early VGA game
+		_maxMemoryLRU = 2 * 1024 * 1024;
+	}
+
+	debugC(1, kDebugLevelResMan, "resMan: Keeping up to %d KB of unlocked resources", _maxMemoryLRU / 1024);
+}
+
 void ResourceManager::freeOldResources() {
-	while (MAX_MEMORY < _memoryLRU) {
+	while ((int)_maxMemoryLRU < _memoryLRU) {
 		assert(!_LRU.empty());
 		Resource *goner = *_LRU.reverse_begin();
 		removeFromLRU(goner);
 		goner->unalloc();
+		_cacheStats.evictions++;
 #ifdef SCI_VERBOSE_RESMAN
 		debug("resMan-debug: LRU: Freeing %s.%03d (%d bytes)", getResourceTypeName(goner->type), goner->number, goner->size);
 #endif
@@ -1049,10 +1075,15 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
+	if (retval->_status == kResStatusNoMalloc) {
 		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
-		removeFromLRU(retval);
+		_cacheStats.misses++;
+		_cacheStats.loadedBytes += retval->size;
+	} else {
+		_cacheStats.hits++;
+		if (retval->_status == kResStatusEnqueued)
+			removeFromLRU(retval);
+	}
 	// Unless an error occurred, the resource is now either
 	// locked or allocated, but never queued or freed.
 
@@ -1994,9 +2025,15 @@ int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file
 		return SCI_ERROR_UNKNOWN_COMPRESSION;
 	}
 
+	// Decompress straight from the volume file's memory if it can hand it
+	// out, rather than reading the packed data through the file byte by byte
+	const byte *packed = file->borrowData(szPacked);
+	Common::MemoryReadStream packedStream(packed, packed ? szPacked : 0);
+	Common::ReadStream *src = packed ? (Common::ReadStream *)&packedStream : file;
+
 	data = new byte[size];
 	_status = kResStatusAllocated;
-	errorNum = data ? dec->unpack(file, data, szPacked, size) : SCI_ERROR_RESOURCE_TOO_BIG;
+	errorNum = data ? dec->unpack(src, data, szPacked, size) : SCI_ERROR_RESOURCE_TOO_BIG;
 	if (errorNum)
 		unalloc();
 
@@ -285,6 +285,16 @@ protected:
 
 typedef Common::HashMap<ResourceId, Resource *, ResourceIdHash> ResourceMap;
 
+/**
+ * Counters of the resource manager's cache of loaded resources.
+ */
+struct ResourceCacheStats {
+	uint32 hits;		///< findResource() calls which found the resource loaded
+	uint32 misses;		///< findResource() calls which had to load the resource
+	uint32 evictions;	///< Resources freed to stay within the memory budget
+	uint32 loadedBytes;	///< Total size of all resources loaded (and decompressed)
+};
+
 class ResourceManager {
 	// FIXME: These 'friend' declarations are meant to be a temporary hack to
 	// ease transition to the ResourceSource class system.
@@ -377,6 +387,15 @@ public:
 	const char *getVolVersionDesc() const { return versionDescription(_volVersion); }
 	ResVersion getVolVersion() const { return _volVersion; }
 
+	/**
+	 * Returns the memory budget for resources which are not locked, in bytes.
+	 * It can be set with the "sci_resource_cache_size" config key, in KB.
+	 */
+	uint32 getMaxMemoryLRU() const { return _maxMemoryLRU; }
+	int getMemoryLRU() const { return _memoryLRU; }
+	int getMemoryLocked() const { return _memoryLocked; }
+	const ResourceCacheStats &getCacheStats() const { return _cacheStats; }
+
 	/**
 	 * Adds the appropriate GM patch from the Sierra MIDI utility as 4.pat, without
 	 * requiring the user to rename the file to 4.pat. Thus, the original Sierra
@@ -422,19 +441,22 @@ public:
 	ResourceType convertResType(byte type);
 
 protected:
-	// Maximum number of bytes to allow being allocated for resources
-	// Note: maxMemory will not be interpreted as a hard limit, only as a restriction
-	// for resources which are not explicitly locked. However, a warning will be
-	// issued whenever this limit is exceeded.
+	// Default number of bytes to allow being allocated for resources during
+	// detection, before the game's version is known
 	enum {
-		MAX_MEMORY = 256 * 1024	// 256KB
+		MAX_MEMORY_DETECTION = 256 * 1024	// 256KB
 	};
 
 	ViewType _viewType; // Used to determine if the game has EGA or VGA graphics
 	Common::List<ResourceSource *> _sources;
+	// Maximum number of bytes to allow being allocated for resources
+	// Note: this will not be interpreted as a hard limit, only as a restriction
+	// for resources which are not explicitly locked.
+	uint32 _maxMemoryLRU;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
 	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	ResourceCacheStats _cacheStats;
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
@@ -489,6 +511,12 @@ protected:
 	Common::SeekableReadStream *getVolumeFile(ResourceSource *source);
 	void loadResource(Resource *res);
 	void freeOldResources();
+
+	/**
+	 * Sets the memory budget for unlocked resources, from the config or
+	 * based on the SCI version of the game.
+	 */
+	void initMaxMemory();
 	void addResource(ResourceId resId, ResourceSource *src, uint32 offset, uint32 size = 0);
 	Resource *updateResource(ResourceId resId, ResourceSource *src, uint32 size);
 	void removeAudioResource(ResourceId resId);
@@ -59,7 +59,8 @@ BaseRenderOSystem::BaseRenderOSystem(BaseGame *inGame) : BaseRenderer(inGame) {
 
 	_borderLeft = _borderRight = _borderTop = _borderBottom = 0;
 	_ratioX = _ratioY = 1.0f;
-	_dirtyRect = nullptr;
+	_showDirtyRects = false;
+	memset(&_dirtyRectStats, 0, sizeof(_dirtyRectStats));
 	_disableDirtyRects = false;
 	if (ConfMan.hasKey("dirty_rects")) {
 		_disableDirtyRects = !ConfMan.getBool("dirty_rects");
@@ -77,7 +78,6 @@ BaseRenderOSystem::~BaseRenderOSystem() {
 		delete ticket;
 	}
 
-	delete _dirtyRect;
 	delete _renderSurface;
 	delete _blankSurface;
 }
@@ -154,8 +154,7 @@ bool BaseRenderOSystem::indicatorFlip() {
 bool BaseRenderOSystem::flip() {
 	if (_skipThisFrame) {
 		_skipThisFrame = false;
-		delete _dirtyRect;
-		_dirtyRect = nullptr;
+		_dirtyRects.reset();
 		g_system->updateScreen();
 		_needsFlip = false;
 
@@ -195,8 +194,7 @@ bool BaseRenderOSystem::flip() {
 			g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->getPitch(), 0, 0, _renderSurface->getWidth(), _renderSurface->getHeight());
 		}
 		//  g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->getPitch(), _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
-		delete _dirtyRect;
-		_dirtyRect = nullptr;
+		_dirtyRects.reset();
 		_needsFlip = false;
 	}
 	_lastFrameIter = _renderQueue.end();
@@ -364,12 +362,7 @@ void BaseRenderOSystem::drawFromQueuedTicket(const RenderQueueIterator &ticket)
 }
 
 void BaseRenderOSystem::addDirtyRect(const Common::Rect &rect) {
-	if (!_dirtyRect) {
-		_dirtyRect = new Common::Rect(rect);
-	} else {
-		_dirtyRect->extend(rect);
-	}
-	_dirtyRect->clip(_renderRect);
+	_dirtyRects.addDirtyRect(rect, _renderRect);
 }
 
 void BaseRenderOSystem::drawTickets() {
@@ -388,7 +381,7 @@ void BaseRenderOSystem::drawTickets() {
 			++it;
 		}
 	}
-	if (!_dirtyRect || _dirtyRect->width() == 0 || _dirtyRect->height() == 0) {
+	if (_dirtyRects.isEmpty()) {
 		it = _renderQueue.begin();
 		while (it != _renderQueue.end()) {
 			RenderTicket *ticket = *it;
@@ -398,29 +391,65 @@ void BaseRenderOSystem::drawTickets() {
 		return;
 	}
 
-	it = _renderQueue.begin();
 	_lastFrameIter = _renderQueue.end();
+
+	const Common::Array<Common::Rect> &dirtyRects = _dirtyRects.getRects();
+	for (uint i = 0; i < dirtyRects.size(); i++) {
+		drawTicketsInRect(dirtyRects[i]);
+	}
+
+	for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
+		// Some tickets want redraw but don't actually clip the dirty area (typically the ones that shouldnt become clear-color)
+		(*it)->_wantsDraw = false;
+	}
+
+	_dirtyRectStats.frames++;
+	_dirtyRectStats.lastRects = dirtyRects.size();
+	_dirtyRectStats.lastPixels = _dirtyRects.getPixelCount();
+	_dirtyRectStats.totalPixels += _dirtyRectStats.lastPixels;
+
+	if (_showDirtyRects) {
+		drawDirtyRectOverlay();
+	}
+
+	it = _renderQueue.begin();
+	// Clean out the old tickets
+	while (it != _renderQueue.end()) {
+		if ((*it)->_isValid == false) {
+			RenderTicket *ticket = *it;
+			addDirtyRect((*it)->_dstRect);
+			it = _renderQueue.erase(it);
+			delete ticket;
+		} else {
+			++it;
+		}
+	}
+
+}
+
+void BaseRenderOSystem::drawTicketsInRect(const Common::Rect &dirtyRect) {
+	RenderQueueIterator it = _renderQueue.begin();
 	// A special case: If the screen has one giant OPAQUE rect to be drawn, then we skip filling
 	// the background color. Typical use-case: Fullscreen FMVs.
 	// Caveat: The FPS-counter will invalidate this.
-	if (it != _lastFrameIter && _renderQueue.front() == _renderQueue.back() && (*it)->_transform._alphaDisable == true) {
+	if (it != _renderQueue.end() && _renderQueue.front() == _renderQueue.back() && (*it)->_transform._alphaDisable == true) {
 		// If our single opaque rect fills the dirty rect, we can skip filling.
-		if (*_dirtyRect != (*it)->_dstRect) {
+		if (dirtyRect != (*it)->_dstRect) {
 			// Apply the clear-color to the dirty rect.
-			_renderSurface->fillRect(*_dirtyRect, _clearColor);
+			_renderSurface->fillRect(dirtyRect, _clearColor);
 		}
 		// Otherwise Do NOT fill.
 	} else {
 		// Apply the clear-color to the dirty rect.
-		_renderSurface->fillRect(*_dirtyRect, _clearColor);
+		_renderSurface->fillRect(dirtyRect, _clearColor);
 	}
 	for (; it != _renderQueue.end(); ++it) {
 		RenderTicket *ticket = *it;
-		if (ticket->_dstRect.intersects(*_dirtyRect)) {
+		if (ticket->_dstRect.intersects(dirtyRect)) {
 			// dstClip is the area we want redrawn.
 			Common::Rect dstClip(ticket->_dstRect);
 			// reduce it to the dirty rect
-			dstClip.clip(*_dirtyRect);
+			dstClip.clip(dirtyRect);
 			// we need to keep track of the position to redraw the dirty rect
 			Common::Rect pos(dstClip);
 			int16 offsetX = ticket->_dstRect.left;
@@ -431,24 +460,25 @@ void BaseRenderOSystem::drawTickets() {
 			drawFromSurface(ticket, &pos, &dstClip);
 			_needsFlip = true;
 		}
-		// Some tickets want redraw but don't actually clip the dirty area (typically the ones that shouldnt become clear-color)
-		ticket->_wantsDraw = false;
 	}
-	g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(_dirtyRect->left, _dirtyRect->top), _renderSurface->getPitch(), _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
+	g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(dirtyRect.left, dirtyRect.top), _renderSurface->getPitch(), dirtyRect.left, dirtyRect.top, dirtyRect.width(), dirtyRect.height());
+}
 
-	it = _renderQueue.begin();
-	// Clean out the old tickets
-	while (it != _renderQueue.end()) {
-		if ((*it)->_isValid == false) {
-			RenderTicket *ticket = *it;
-			addDirtyRect((*it)->_dstRect);
-			it = _renderQueue.erase(it);
-			delete ticket;
-		} else {
-			++it;
-		}
+void BaseRenderOSystem::drawDirtyRectOverlay() {
+	// Show the whole frame, so outlines from earlier frames don't linger
+	g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->getPitch(), 0, 0, _renderSurface->getWidth(), _renderSurface->getHeight());
+
+	Graphics::Surface *screen = g_system->lockScreen();
+	if (!screen) {
+		return;
 	}
 
+	uint32 color = screen->getFormat().ARGBToColor(255, 255, 0, 255);
+	const Common::Array<Common::Rect> &dirtyRects = _dirtyRects.getRects();
+	for (uint i = 0; i < dirtyRects.size(); i++) {
+		screen->frameRect(dirtyRects[i], color);
+	}
+	g_system->unlockScreen();
 }
 
 // Replacement for SDL2's SDL_RenderCopy
@@ -30,6 +30,7 @@
 #define WINTERMUTE_BASE_RENDERER_SDL_H
 
 #include "engines/wintermute/base/gfx/base_renderer.h"
+#include "engines/wintermute/base/gfx/osystem/dirty_rect_container.h"
 #include "common/rect.h"
 #include "graphics/surface.h"
 #include "common/list.h"
@@ -112,6 +113,22 @@ public:
 	void endSaveLoad();
 	void drawSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Graphics::TransformStruct &transform);
 	BaseSurface *createSurface() override;
+
+	/**
+	 * Outline the regions redrawn in each frame on screen.
+	 * @param enabled whether to show the outlines
+	 */
+	void setShowDirtyRects(bool enabled) { _showDirtyRects = enabled; }
+	bool getShowDirtyRects() const { return _showDirtyRects; }
+
+	/** Redraw counters, shown by the dirty_rects debugger command */
+	struct DirtyRectStats {
+		uint32 frames; ///< frames that redrew anything
+		uint32 lastRects; ///< regions redrawn in the last frame
+		uint32 lastPixels; ///< pixels redrawn in the last frame
+		uint64 totalPixels; ///< pixels redrawn in all frames
+	};
+	const DirtyRectStats &getDirtyRectStats() const { return _dirtyRectStats; }
 private:
 	/**
 	 * Mark a specified rect of the screen as dirty.
@@ -122,11 +139,22 @@ private:
 	 * Traverse the tickets that are dirty, and draw them
 	 */
 	void drawTickets();
+	/**
+	 * Redraw the tickets overlapping a single dirty region
+	 * @param dirtyRect the region to be redrawn
+	 */
+	void drawTicketsInRect(const Common::Rect &dirtyRect);
+	/**
+	 * Outline the dirty regions on screen, for debugging
+	 */
+	void drawDirtyRectOverlay();
 	// Non-dirty-rects:
 	void drawFromSurface(RenderTicket *ticket);
 	// Dirty-rects:
 	void drawFromSurface(RenderTicket *ticket, Common::Rect *dstRect, Common::Rect *clipRect);
-	Common::Rect *_dirtyRect;
+	DirtyRectContainer _dirtyRects;
+	bool _showDirtyRects;
+	DirtyRectStats _dirtyRectStats;
 	Common::List<RenderTicket *> _renderQueue;
 
 	bool _needsFlip;
@@ -0,0 +1,81 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/wintermute/base/gfx/osystem/dirty_rect_container.h"
+
+namespace Wintermute {
+
+DirtyRectContainer::DirtyRectContainer() {
+}
+
+void DirtyRectContainer::addDirtyRect(const Common::Rect &rect, const Common::Rect &clipRect) {
+	Common::Rect newRect(rect);
+	newRect.clip(clipRect);
+	if (newRect.isEmpty())
+		return;
+
+	if (_rects.empty())
+		_boundingRect = newRect;
+	else
+		_boundingRect.extend(newRect);
+
+	// Merge with every region the new one overlaps. The merged region may
+	// overlap regions it didn't before, so start over after each merge.
+	uint i = 0;
+	while (i < _rects.size()) {
+		if (_rects[i].contains(newRect))
+			return;
+
+		if (_rects[i].intersects(newRect)) {
+			newRect.extend(_rects[i]);
+			_rects.remove_at(i);
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	_rects.push_back(newRect);
+
+	uint32 boundingArea = (uint32)_boundingRect.width() * _boundingRect.height();
+	if (_rects.size() > kMaxRects || getPixelCount() > boundingArea / 4 * 3)
+		collapse();
+}
+
+void DirtyRectContainer::reset() {
+	_rects.clear();
+	_boundingRect = Common::Rect();
+}
+
+uint32 DirtyRectContainer::getPixelCount() const {
+	uint32 pixels = 0;
+	for (uint i = 0; i < _rects.size(); i++)
+		pixels += (uint32)_rects[i].width() * _rects[i].height();
+	return pixels;
+}
+
+void DirtyRectContainer::collapse() {
+	_rects.clear();
+	_rects.push_back(_boundingRect);
+}
+
+} // End of namespace Wintermute
@@ -0,0 +1,74 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef WINTERMUTE_DIRTY_RECT_CONTAINER_H
+#define WINTERMUTE_DIRTY_RECT_CONTAINER_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Wintermute {
+
+/**
+ * The set of screen regions that need to be redrawn in the next frame.
+ * Rectangles that overlap are merged, so the regions never overlap and no
+ * pixel is drawn twice. Many small rectangles are not worth the per-region
+ * overhead though, so once there are more than kMaxRects regions, or they
+ * cover most of their bounding box anyway, they are collapsed into that
+ * bounding box.
+ */
+class DirtyRectContainer {
+public:
+	DirtyRectContainer();
+
+	/**
+	 * Mark a region as dirty.
+	 * @param rect the region to be marked as dirty
+	 * @param clipRect the area the region is clipped to, usually the screen
+	 */
+	void addDirtyRect(const Common::Rect &rect, const Common::Rect &clipRect);
+
+	/** Forget all dirty regions, after they have been redrawn */
+	void reset();
+
+	bool isEmpty() const { return _rects.empty(); }
+
+	/** The dirty regions, which don't overlap each other */
+	const Common::Array<Common::Rect> &getRects() const { return _rects; }
+
+	/** The smallest rectangle containing all dirty regions */
+	const Common::Rect &getBoundingRect() const { return _boundingRect; }
+
+	/** The number of pixels covered by the dirty regions */
+	uint32 getPixelCount() const;
+
+	static const uint kMaxRects = 16;
+private:
+	void collapse();
+
+	Common::Array<Common::Rect> _rects;
+	Common::Rect _boundingRect;
+};
+
+} // End of namespace Wintermute
+
+#endif
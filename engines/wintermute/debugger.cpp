@@ -25,12 +25,14 @@
 #include "engines/wintermute/base/base_engine.h"
 #include "engines/wintermute/base/base_file_manager.h"
 #include "engines/wintermute/base/base_game.h"
+#include "engines/wintermute/base/gfx/osystem/base_render_osystem.h"
 
 namespace Wintermute {
 
 Console::Console(WintermuteEngine *vm) : GUI::Debugger(), _engineRef(vm) {
 	registerCmd("show_fps", WRAP_METHOD(Console, Cmd_ShowFps));
 	registerCmd("dump_file", WRAP_METHOD(Console, Cmd_DumpFile));
+	registerCmd("dirty_rects", WRAP_METHOD(Console, Cmd_DirtyRects));
 }
 
 Console::~Console(void) {
@@ -81,4 +83,27 @@ bool Console::Cmd_DumpFile(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::Cmd_DirtyRects(int argc, const char **argv) {
+	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_engineRef->_game->_renderer);
+
+	if (argc > 1) {
+		if (Common::String(argv[1]) == "show") {
+			renderer->setShowDirtyRects(true);
+		} else if (Common::String(argv[1]) == "hide") {
+			renderer->setShowDirtyRects(false);
+		} else {
+			debugPrintf("Usage: %s [show|hide]\n", argv[0]);
+			return true;
+		}
+	}
+
+	const BaseRenderOSystem::DirtyRectStats &stats = renderer->getDirtyRectStats();
+	debugPrintf("Last frame: %d pixels redrawn in %d regions\n", stats.lastPixels, stats.lastRects);
+	if (stats.frames) {
+		debugPrintf("Average: %d pixels redrawn over %d frames\n", (uint32)(stats.totalPixels / stats.frames), stats.frames);
+	}
+	debugPrintf("Outlines: %s\n", renderer->getShowDirtyRects() ? "shown" : "hidden");
+	return true;
+}
+
 } // End of namespace Wintermute
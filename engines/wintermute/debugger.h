@@ -35,6 +35,7 @@ public:
 
 	bool Cmd_ShowFps(int argc, const char **argv);
 	bool Cmd_DumpFile(int argc, const char **argv);
+	bool Cmd_DirtyRects(int argc, const char **argv);
 private:
 	WintermuteEngine *_engineRef;
 };
@@ -38,6 +38,11 @@
 
 //#define ENABLE_BILINEAR
 
+#if defined(__SSE2__) && defined(SCUMM_LITTLE_ENDIAN)
+#define USE_SSE2_BLITTING
+#include <emmintrin.h>
+#endif
+
 namespace Graphics {
 
 static const int kBModShift = 0;//img->format.bShift;
@@ -64,6 +69,174 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
 void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
 
+#ifdef USE_SSE2_BLITTING
+
+/*
+ * The SSE2 blitters below handle four pixels at a time, two per 128-bit
+ * register once the channels are widened to 16 bits. Every one of them is
+ * bit-exact with the scalar loop it accompanies; the scalar loops handle the
+ * remaining pixels of each row.
+ */
+
+/**
+ * Load four source pixels, honouring a negative inStep for horizontal
+ * flipping.
+ */
+static inline __m128i loadPixels(const byte *in, int32 inStep) {
+	if (inStep > 0)
+		return _mm_loadu_si128((const __m128i *)in);
+
+	// The pixels to the left of in are read in reverse order
+	return _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(in - 12)), _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+/**
+ * Replicate the alpha channel of the two pixels in v over all their channels.
+ */
+static inline __m128i broadcastAlpha(__m128i v) {
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+}
+
+/**
+ * Per channel factors for the additive and subtractive blitters: a
+ * color modulation of 255 is treated as 256, which turns their ">> 16"
+ * into the ">> 8" of the unmodulated case. The alpha channel is zeroed,
+ * so that the blend leaves it untouched.
+ */
+static inline __m128i tintFactors(uint32 color) {
+	const int16 cr = ((color >> kRModShift) & 0xFF) == 255 ? 256 : (color >> kRModShift) & 0xFF;
+	const int16 cg = ((color >> kGModShift) & 0xFF) == 255 ? 256 : (color >> kGModShift) & 0xFF;
+	const int16 cb = ((color >> kBModShift) & 0xFF) == 255 ? 256 : (color >> kBModShift) & 0xFF;
+	return _mm_set_epi16(cr, cg, cb, 0, cr, cg, cb, 0);
+}
+
+/**
+ * Alpha blend two unmodulated pixels, widened to 16 bits per channel.
+ */
+static inline __m128i alphaBlendVector(__m128i in, __m128i out) {
+	const __m128i a = broadcastAlpha(in);
+	const __m128i invA = _mm_sub_epi16(_mm_set1_epi16(255), a);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(in, a), _mm_mullo_epi16(out, invA)), 8);
+}
+
+/**
+ * Alpha blend two color modulated pixels, widened to 16 bits per channel.
+ */
+static inline __m128i alphaBlendTintedVector(__m128i in, __m128i out, __m128i ca, __m128i tint) {
+	const __m128i ina = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlpha(in), ca), 8);
+	const __m128i dst = _mm_srli_epi16(_mm_mullo_epi16(out, _mm_sub_epi16(_mm_set1_epi16(255), ina)), 8);
+	return _mm_add_epi16(dst, _mm_mulhi_epu16(_mm_mullo_epi16(in, ina), tint));
+}
+
+static void doBlitAlphaBlendSSE2(byte *in, byte *out, uint32 count, int32 inStep, uint32 color) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(0xFF);
+
+	if (color == 0xffffffff) {
+		for (; count > 0; count -= 4) {
+			const __m128i src = loadPixels(in, inStep);
+			const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+
+			__m128i res = _mm_packus_epi16(alphaBlendVector(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero)),
+			                               alphaBlendVector(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero)));
+			res = _mm_or_si128(res, alphaMask);
+
+			// Fully transparent source pixels leave the target untouched
+			const __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(src, alphaMask), zero);
+			res = _mm_or_si128(_mm_and_si128(transparent, dst), _mm_andnot_si128(transparent, res));
+			_mm_storeu_si128((__m128i *)out, res);
+
+			in += inStep * 4;
+			out += 16;
+		}
+	} else {
+		const __m128i ca = _mm_set1_epi16((color >> kAModShift) & 0xFF);
+		const int16 cr = (color >> kRModShift) & 0xFF;
+		const int16 cg = (color >> kGModShift) & 0xFF;
+		const int16 cb = (color >> kBModShift) & 0xFF;
+		const __m128i tint = _mm_set_epi16(cr, cg, cb, 0, cr, cg, cb, 0);
+
+		for (; count > 0; count -= 4) {
+			const __m128i src = loadPixels(in, inStep);
+			const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+
+			__m128i res = _mm_packus_epi16(alphaBlendTintedVector(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero), ca, tint),
+			                               alphaBlendTintedVector(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero), ca, tint));
+			_mm_storeu_si128((__m128i *)out, _mm_or_si128(res, alphaMask));
+
+			in += inStep * 4;
+			out += 16;
+		}
+	}
+}
+
+/**
+ * Additively blend two pixels, widened to 16 bits per channel. ina is the
+ * (modulated) source alpha, broadcast over all channels.
+ */
+static inline __m128i additiveBlendVector(__m128i in, __m128i out, __m128i ina, __m128i tint) {
+	return _mm_add_epi16(out, _mm_mulhi_epu16(_mm_mullo_epi16(in, ina), tint));
+}
+
+static void doBlitAdditiveBlendSSE2(byte *in, byte *out, uint32 count, int32 inStep, uint32 color) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i tint = tintFactors(color);
+	const bool modulateAlpha = (color != 0xffffffff);
+	const __m128i ca = _mm_set1_epi16((color >> kAModShift) & 0xFF);
+
+	for (; count > 0; count -= 4) {
+		const __m128i src = loadPixels(in, inStep);
+		const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+		const __m128i srcLo = _mm_unpacklo_epi8(src, zero);
+		const __m128i srcHi = _mm_unpackhi_epi8(src, zero);
+
+		__m128i inaLo = broadcastAlpha(srcLo);
+		__m128i inaHi = broadcastAlpha(srcHi);
+		if (modulateAlpha) {
+			inaLo = _mm_srli_epi16(_mm_mullo_epi16(inaLo, ca), 8);
+			inaHi = _mm_srli_epi16(_mm_mullo_epi16(inaHi, ca), 8);
+		}
+
+		// The pack saturates the sums at 255
+		const __m128i res = _mm_packus_epi16(additiveBlendVector(srcLo, _mm_unpacklo_epi8(dst, zero), inaLo, tint),
+		                                     additiveBlendVector(srcHi, _mm_unpackhi_epi8(dst, zero), inaHi, tint));
+		_mm_storeu_si128((__m128i *)out, res);
+
+		in += inStep * 4;
+		out += 16;
+	}
+}
+
+/**
+ * Subtractively blend two pixels, widened to 16 bits per channel.
+ */
+static inline __m128i subtractiveBlendVector(__m128i in, __m128i out, __m128i tint) {
+	// tint * alpha fits into 16 bits, and so does in * out: the high half of
+	// their product shifted by 8 is the full product shifted by 24
+	const __m128i factor = _mm_mullo_epi16(broadcastAlpha(in), tint);
+	return _mm_sub_epi16(out, _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(in, out), factor), 8));
+}
+
+static void doBlitSubtractiveBlendSSE2(byte *in, byte *out, uint32 count, int32 inStep, uint32 color) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i tint = tintFactors(color);
+	const __m128i alphaMask = (color == 0xffffffff) ? zero : _mm_set1_epi32(0xFF);
+
+	for (; count > 0; count -= 4) {
+		const __m128i src = loadPixels(in, inStep);
+		const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+
+		const __m128i res = _mm_packus_epi16(subtractiveBlendVector(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero), tint),
+		                                     subtractiveBlendVector(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero), tint));
+		_mm_storeu_si128((__m128i *)out, _mm_or_si128(res, alphaMask));
+
+		in += inStep * 4;
+		out += 16;
+	}
+}
+
+#endif // USE_SSE2_BLITTING
+
 TransparentSurface::TransparentSurface() : Surface(), _alphaMode(ALPHA_FULL) {}
 
 TransparentSurface::TransparentSurface(const Surface &surf, bool copyData) : Surface(surf), _alphaMode(ALPHA_FULL) {
@@ -139,7 +312,14 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef USE_SSE2_BLITTING
+			j = width & ~3;
+			doBlitAlphaBlendSSE2(in, out, j, inStep, color);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kAIndex] = 255;
@@ -164,7 +344,14 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef USE_SSE2_BLITTING
+			j = width & ~3;
+			doBlitAlphaBlendSSE2(in, out, j, inStep, color);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
 				out[kAIndex] = 255;
@@ -197,7 +384,14 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef USE_SSE2_BLITTING
+			j = width & ~3;
+			doBlitAdditiveBlendSSE2(in, out, j, inStep, color);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kRIndex] = MIN((in[kRIndex] * in[kAIndex] >> 8) + out[kRIndex], 255);
@@ -221,7 +415,14 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef USE_SSE2_BLITTING
+			j = width & ~3;
+			doBlitAdditiveBlendSSE2(in, out, j, inStep, color);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
 
@@ -264,7 +465,14 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef USE_SSE2_BLITTING
+			j = width & ~3;
+			doBlitSubtractiveBlendSSE2(in, out, j, inStep, color);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kRIndex] = MAX(out[kRIndex] - ((in[kRIndex] * out[kRIndex]) * in[kAIndex] >> 16), 0);
@@ -287,23 +495,30 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef USE_SSE2_BLITTING
+			j = width & ~3;
+			doBlitSubtractiveBlendSSE2(in, out, j, inStep, color);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				out[kAIndex] = 255;
 				if (cb != 255) {
-					out[kBIndex] = MAX(out[kBIndex] - ((in[kBIndex] * cb  * (out[kBIndex]) * in[kAIndex]) >> 24), 0);
+					out[kBIndex] = MAX(out[kBIndex] - (int)(((uint32)in[kBIndex] * cb * out[kBIndex] * in[kAIndex]) >> 24), 0);
 				} else {
 					out[kBIndex] = MAX(out[kBIndex] - (in[kBIndex] * (out[kBIndex]) * in[kAIndex] >> 16), 0);
 				}
 
 				if (cg != 255) {
-					out[kGIndex] = MAX(out[kGIndex] - ((in[kGIndex] * cg  * (out[kGIndex]) * in[kAIndex]) >> 24), 0);
+					out[kGIndex] = MAX(out[kGIndex] - (int)(((uint32)in[kGIndex] * cg * out[kGIndex] * in[kAIndex]) >> 24), 0);
 				} else {
 					out[kGIndex] = MAX(out[kGIndex] - (in[kGIndex] * (out[kGIndex]) * in[kAIndex] >> 16), 0);
 				}
 
 				if (cr != 255) {
-					out[kRIndex] = MAX(out[kRIndex] - ((in[kRIndex] * cr * (out[kRIndex]) * in[kAIndex]) >> 24), 0);
+					out[kRIndex] = MAX(out[kRIndex] - (int)(((uint32)in[kRIndex] * cr * out[kRIndex] * in[kAIndex]) >> 24), 0);
 				} else {
 					out[kRIndex] = MAX(out[kRIndex] - (in[kRIndex] * (out[kRIndex]) * in[kAIndex] >> 16), 0);
 				}
@@ -85,9 +85,16 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/array.h"
+#include "common/endian.h"
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
 
+#if defined(__SSE2__)
+#define USE_SSE2_YUV
+#include <emmintrin.h>
+#endif
+
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
 }
@@ -198,8 +205,183 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
 
+#ifdef USE_SSE2_YUV
+
+/*
+ * The SSE2 converters below handle eight pixels at a time, and are bit-exact
+ * with the lookup tables: those only clamp (and for ITU luminance, rescale)
+ * the sum of the luminance and the chroma offset before converting it to
+ * the pixel format. Pixels left over at the end of a row go through the
+ * tables.
+ */
+
+/** The constants needed to convert to a destination format */
+struct YUVToRGBVectorFormat {
+	YUVToRGBVectorFormat(const YUVToRGBLookup *lookup) {
+		const Graphics::PixelFormat format = lookup->getFormat();
+
+		itu = (lookup->getScale() == YUVToRGBManager::kScaleITU);
+		lo = _mm_set1_epi16(itu ? 16 : 0);
+		hi = _mm_set1_epi16(itu ? 235 : 255);
+
+		rLoss = _mm_cvtsi32_si128(format.rLoss);
+		gLoss = _mm_cvtsi32_si128(format.gLoss);
+		bLoss = _mm_cvtsi32_si128(format.bLoss);
+		rShift = _mm_cvtsi32_si128(format.rShift);
+		gShift = _mm_cvtsi32_si128(format.gShift);
+		bShift = _mm_cvtsi32_si128(format.bShift);
+		alpha = (0xFF >> format.aLoss) << format.aShift;
+	}
+
+	bool itu;
+	__m128i lo, hi;
+	__m128i rLoss, gLoss, bLoss;
+	__m128i rShift, gShift, bShift;
+	uint32 alpha;
+};
+
+/**
+ * Multiply the signed chroma values in c by factor / 16384, rounding towards
+ * zero like the (int16) casts building the chroma tables. The factors used
+ * below give the same result as those tables for every chroma value.
+ */
+static inline __m128i scaleChroma(__m128i c, int factor) {
+	const __m128i sign = _mm_srai_epi16(c, 15);
+	const __m128i magnitude = _mm_sub_epi16(_mm_xor_si128(c, sign), sign);
+	const __m128i scaled = _mm_mulhi_epu16(_mm_slli_epi16(magnitude, 2), _mm_set1_epi16((int16)factor));
+	return _mm_sub_epi16(_mm_xor_si128(scaled, sign), sign);
+}
+
+/**
+ * Compute the chroma offsets of eight pixels, from their u and v values
+ * in the low halves of u and v.
+ */
+static inline void computeChroma(__m128i u, __m128i v, __m128i &crR, __m128i &crbG, __m128i &cbB) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+	const __m128i cb = _mm_sub_epi16(_mm_unpacklo_epi8(u, zero), bias);
+	const __m128i cr = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), bias);
+
+	// 0.419 / 0.299, 0.299 / 0.419, 0.114 / 0.331 and 0.587 / 0.331
+	crR  = scaleChroma(cr, 22960);
+	crbG = _mm_add_epi16(scaleChroma(cr, 11692), scaleChroma(cb, 5642));
+	cbB  = scaleChroma(cb, 29055);
+}
+
+/**
+ * Convert eight luminance values with the given chroma offsets, and store
+ * the resulting pixels at dstPtr.
+ */
+template<typename PixelInt>
+static inline void putPixels(byte *dstPtr, const byte *ySrc, __m128i crR, __m128i crbG, __m128i cbB, const YUVToRGBVectorFormat &f) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)ySrc), zero);
+	__m128i r = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, crR), f.lo), f.hi);
+	__m128i g = _mm_min_epi16(_mm_max_epi16(_mm_sub_epi16(y, crbG), f.lo), f.hi);
+	__m128i b = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, cbB), f.lo), f.hi);
+
+	if (f.itu) {
+		// (v - 16) * 255 / 219, with the division done as a multiplication
+		const __m128i scale = _mm_set1_epi16(255);
+		const __m128i inv219 = _mm_set1_epi16((int16)38305);
+		r = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(_mm_sub_epi16(r, f.lo), scale), inv219), 7);
+		g = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(_mm_sub_epi16(g, f.lo), scale), inv219), 7);
+		b = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(_mm_sub_epi16(b, f.lo), scale), inv219), 7);
+	}
+
+	r = _mm_srl_epi16(r, f.rLoss);
+	g = _mm_srl_epi16(g, f.gLoss);
+	b = _mm_srl_epi16(b, f.bLoss);
+
+	if (sizeof(PixelInt) == 2) {
+		__m128i pix = _mm_set1_epi16((int16)f.alpha);
+		pix = _mm_or_si128(pix, _mm_sll_epi16(r, f.rShift));
+		pix = _mm_or_si128(pix, _mm_sll_epi16(g, f.gShift));
+		pix = _mm_or_si128(pix, _mm_sll_epi16(b, f.bShift));
+		_mm_storeu_si128((__m128i *)dstPtr, pix);
+	} else {
+		__m128i pix0 = _mm_set1_epi32(f.alpha), pix1 = pix0;
+		pix0 = _mm_or_si128(pix0, _mm_sll_epi32(_mm_unpacklo_epi16(r, zero), f.rShift));
+		pix1 = _mm_or_si128(pix1, _mm_sll_epi32(_mm_unpackhi_epi16(r, zero), f.rShift));
+		pix0 = _mm_or_si128(pix0, _mm_sll_epi32(_mm_unpacklo_epi16(g, zero), f.gShift));
+		pix1 = _mm_or_si128(pix1, _mm_sll_epi32(_mm_unpackhi_epi16(g, zero), f.gShift));
+		pix0 = _mm_or_si128(pix0, _mm_sll_epi32(_mm_unpacklo_epi16(b, zero), f.bShift));
+		pix1 = _mm_or_si128(pix1, _mm_sll_epi32(_mm_unpackhi_epi16(b, zero), f.bShift));
+		_mm_storeu_si128((__m128i *)dstPtr, pix0);
+		_mm_storeu_si128((__m128i *)(dstPtr + 16), pix1);
+	}
+}
+
+/**
+ * Convert the pixels from x to width of a row through the lookup tables,
+ * with one chroma value per chromaStep pixels.
+ */
+template<typename PixelInt>
+static void convertRowTail(byte *dstPtr, const YUVToRGBLookup *lookup, const int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int x, int width, int chromaStep) {
+	const int16 *Cr_r_tab = colorTab;
+	const int16 *Cr_g_tab = Cr_r_tab + 256;
+	const int16 *Cb_g_tab = Cr_g_tab + 256;
+	const int16 *Cb_b_tab = Cb_g_tab + 256;
+	const uint32 *rgbToPix = lookup->getRGBToPix();
+
+	for (; x < width; x++) {
+		const int c = x / chromaStep;
+		const uint32 *L = &rgbToPix[ySrc[x]];
+		((PixelInt *)dstPtr)[x] = (L[Cr_r_tab[vSrc[c]]] | L[Cr_g_tab[vSrc[c]] + Cb_g_tab[uSrc[c]]] | L[Cb_b_tab[uSrc[c]]]);
+	}
+}
+
+/**
+ * Convert one row of pixels with one chroma value per pixel.
+ */
+template<typename PixelInt>
+static void convertRow444SSE2(byte *dstPtr, const YUVToRGBLookup *lookup, const YUVToRGBVectorFormat &f, const int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width) {
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i crR, crbG, cbB;
+		computeChroma(_mm_loadl_epi64((const __m128i *)(uSrc + x)), _mm_loadl_epi64((const __m128i *)(vSrc + x)), crR, crbG, cbB);
+		putPixels<PixelInt>(dstPtr + x * sizeof(PixelInt), ySrc + x, crR, crbG, cbB, f);
+	}
+
+	convertRowTail<PixelInt>(dstPtr, lookup, colorTab, ySrc, uSrc, vSrc, x, width, 1);
+}
+
+/**
+ * Convert two rows of pixels sharing one chroma value per two by two pixels.
+ */
+template<typename PixelInt>
+static void convertRow420SSE2(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const YUVToRGBVectorFormat &f, const int16 *colorTab, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width) {
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i u = _mm_cvtsi32_si128(READ_UINT32(uSrc + x / 2));
+		__m128i v = _mm_cvtsi32_si128(READ_UINT32(vSrc + x / 2));
+
+		__m128i crR, crbG, cbB;
+		computeChroma(_mm_unpacklo_epi8(u, u), _mm_unpacklo_epi8(v, v), crR, crbG, cbB);
+		putPixels<PixelInt>(dstPtr + x * sizeof(PixelInt), ySrc + x, crR, crbG, cbB, f);
+		putPixels<PixelInt>(dstPtr + dstPitch + x * sizeof(PixelInt), ySrc + yPitch + x, crR, crbG, cbB, f);
+	}
+
+	convertRowTail<PixelInt>(dstPtr, lookup, colorTab, ySrc, uSrc, vSrc, x, width, 2);
+	convertRowTail<PixelInt>(dstPtr + dstPitch, lookup, colorTab, ySrc + yPitch, uSrc, vSrc, x, width, 2);
+}
+
+#endif // USE_SSE2_YUV
+
 template<typename PixelInt>
 void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+#ifdef USE_SSE2_YUV
+	const YUVToRGBVectorFormat format(lookup);
+
+	for (int h = 0; h < yHeight; h++) {
+		convertRow444SSE2<PixelInt>(dstPtr, lookup, format, colorTab, ySrc, uSrc, vSrc, yWidth);
+
+		dstPtr += dstPitch;
+		ySrc += yPitch;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+#else
 	// Keep the tables in pointers here to avoid a dereference on each pixel
 	const int16 *Cr_r_tab = colorTab;
 	const int16 *Cr_g_tab = Cr_r_tab + 256;
@@ -227,6 +409,7 @@ void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 		uSrc += uvPitch - yWidth;
 		vSrc += uvPitch - yWidth;
 	}
+#endif
 }
 
 void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
@@ -247,6 +430,19 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 template<typename PixelInt>
 void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	int halfHeight = yHeight >> 1;
+
+#ifdef USE_SSE2_YUV
+	const YUVToRGBVectorFormat format(lookup);
+
+	for (int h = 0; h < halfHeight; h++) {
+		convertRow420SSE2<PixelInt>(dstPtr, dstPitch, lookup, format, colorTab, ySrc, yPitch, uSrc, vSrc, yWidth);
+
+		dstPtr += dstPitch << 1;
+		ySrc += yPitch << 1;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+#else
 	int halfWidth = yWidth >> 1;
 
 	// Keep the tables in pointers here to avoid a dereference on each pixel
@@ -281,6 +477,7 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 		uSrc += uvPitch - halfWidth;
 		vSrc += uvPitch - halfWidth;
 	}
+#endif
 }
 
 void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
@@ -326,6 +523,41 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 
 template<typename PixelInt>
 void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	// Columns which do not fill a chroma block are left untouched
+	int quarterWidth = yWidth >> 2;
+
+#ifdef USE_SSE2_YUV
+	// Interpolate the chroma of a row first, then convert it in one go
+	const YUVToRGBVectorFormat format(lookup);
+	Common::Array<byte> chroma;
+	chroma.resize(yWidth * 2);
+	byte *uRow = chroma.begin();
+	byte *vRow = uRow + yWidth;
+
+	for (int y = 0; y < yHeight; y++) {
+		for (int x = 0; x < quarterWidth; x++) {
+			int targetY = y >> 2;
+			int yDiff = y & 3;
+			int index = targetY * uvPitch + x;
+
+			READ_QUAD(uSrc, u);
+			READ_QUAD(vSrc, v);
+
+			for (int xDiff = 0; xDiff < 4; xDiff++) {
+				byte u, v;
+				DO_INTERPOLATION(u);
+				DO_INTERPOLATION(v);
+				uRow[x * 4 + xDiff] = u;
+				vRow[x * 4 + xDiff] = v;
+			}
+		}
+
+		convertRow444SSE2<PixelInt>(dstPtr, lookup, format, colorTab, ySrc, uRow, vRow, quarterWidth * 4);
+
+		dstPtr += dstPitch;
+		ySrc += yPitch;
+	}
+#else
 	// Keep the tables in pointers here to avoid a dereference on each pixel
 	const int16 *Cr_r_tab = colorTab;
 	const int16 *Cr_g_tab = Cr_r_tab + 256;
@@ -333,8 +565,6 @@ void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const int16 *Cb_b_tab = Cb_g_tab + 256;
 	const uint32 *rgbToPix = lookup->getRGBToPix();
 
-	int quarterWidth = yWidth >> 2;
-
 	for (int y = 0; y < yHeight; y++) {
 		for (int x = 0; x < quarterWidth; x++) {
 			// Perform bilinear interpolation on the the chroma values
@@ -359,9 +589,10 @@ void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 			DO_YUV410_PIXEL();
 		}
 
-		dstPtr += dstPitch - yWidth * sizeof(PixelInt);
-		ySrc += yPitch - yWidth;
+		dstPtr += dstPitch - quarterWidth * 4 * sizeof(PixelInt);
+		ySrc += yPitch - quarterWidth * 4;
 	}
+#endif
 }
 
 #undef READ_QUAD
@@ -373,7 +604,6 @@ void YUVToRGBManager::convert410(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert(dst && dst->getPixels());
 	assert(dst->getFormat().bytesPerPixel == 2 || dst->getFormat().bytesPerPixel == 4);
 	assert(ySrc && uSrc && vSrc);
-	assert((yWidth & 3) == 0);
 	assert((yHeight & 3) == 0);
 
 	const YUVToRGBLookup *lookup = getLookup(dst->getFormat(), scale);
@@ -165,7 +165,9 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 
 		close();
 	} else if (cmd == kCancelCmd) {
-		// User cancelled, so we don't do anything and just leave.
+		// User cancelled, so we don't do anything and just leave. Keep what
+		// we learned about the files scanned so far, though.
+		EngineMan.flushDetectionCache();
 		_games.clear();
 		close();
 	} else {
@@ -188,8 +190,9 @@ void MassAddDialog::handleTickle() {
 			continue;
 		}
 
-		// Run the detector on the dir
-		GameList candidates(EngineMan.detectGames(files));
+		// Run the detector on the dir. The detection cache is written once
+		// the whole scan is done, rather than after every directory.
+		GameList candidates(EngineMan.detectGames(files, false));
 
 		// Just add all detected games / game variants. If we get more than one,
 		// that either means the directory contains multiple games, or the detector
@@ -255,6 +258,8 @@ void MassAddDialog::handleTickle() {
 	Common::String buf;
 
 	if (_scanStack.empty()) {
+		EngineMan.flushDetectionCache();
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
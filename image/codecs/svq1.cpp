@@ -90,10 +90,17 @@ SVQ1Decoder::~SVQ1Decoder() {
 
 #define ALIGN(x, a) (((x)+(a)-1)&~((a)-1))
 
+// The frame is read exclusively through the bit stream, so it can read ahead
+#ifdef HAVE_INT64
+typedef Common::BitStreamCached32BEMSB SVQ1BitStream;
+#else
+typedef Common::BitStream32BEMSB SVQ1BitStream;
+#endif
+
 const Graphics::Surface *SVQ1Decoder::decodeFrame(Common::SeekableReadStream &stream) {
 	debug(1, "SVQ1Decoder::decodeImage()");
 
-	Common::BitStream32BEMSB frameData(stream);
+	SVQ1BitStream frameData(stream);
 
 	uint32 frameCode = frameData.getBits(22);
 	debug(1, " frameCode: %d", frameCode);
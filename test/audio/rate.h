@@ -0,0 +1,212 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decoders/pcm.h"
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	static int16 sample(int i) {
+		return (int16)((i * 7919) % 65536 - 32768);
+	}
+
+	static Audio::AudioStream *createStream(const int16 *data, int samples, int rate, bool stereo) {
+		return Audio::makePCMStream((const byte *)data, samples * 2, rate,
+		                            Audio::FLAG_16BITS | Audio::FLAG_NATIVE_ENDIAN | (stereo ? Audio::FLAG_STEREO : 0),
+		                            DisposeAfterUse::NO);
+	}
+
+	void copyTestTemplate(const bool stereo, const int frames, const Audio::st_volume_t volL, const Audio::st_volume_t volR) {
+		const int channels = stereo ? 2 : 1;
+
+		int16 *input = new int16[frames * channels];
+		for (int i = 0; i < frames * channels; i++)
+			input[i] = sample(i);
+
+		int16 *output = new int16[frames * 2];
+		int16 *expected = new int16[frames * 2];
+		for (int i = 0; i < frames * 2; i++)
+			output[i] = expected[i] = sample(i * 3 + 1);
+
+		for (int i = 0; i < frames; i++) {
+			const int16 in0 = input[i * channels];
+			const int16 in1 = input[i * channels + channels - 1];
+			Audio::clampedAdd(expected[i * 2 + 0], (in0 * (int)volL) / Audio::Mixer::kMaxMixerVolume);
+			Audio::clampedAdd(expected[i * 2 + 1], (in1 * (int)volR) / Audio::Mixer::kMaxMixerVolume);
+		}
+
+		Audio::AudioStream *s = createStream(input, frames * channels, 22050, stereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 22050, stereo);
+
+		TS_ASSERT_EQUALS(converter->flow(*s, output, frames, volL, volR), frames);
+		TS_ASSERT_EQUALS(memcmp(output, expected, frames * 2 * sizeof(int16)), 0);
+
+		delete converter;
+		delete s;
+		delete[] expected;
+		delete[] output;
+		delete[] input;
+	}
+
+public:
+	void test_copy_mono() {
+		copyTestTemplate(false, 1003, 200, 131);
+	}
+
+	void test_copy_stereo() {
+		copyTestTemplate(true, 1003, 256, 17);
+	}
+
+	void test_copy_end_of_data() {
+		int16 input[10];
+		for (int i = 0; i < ARRAYSIZE(input); i++)
+			input[i] = sample(i);
+
+		int16 output[64];
+		memset(output, 0, sizeof(output));
+
+		Audio::AudioStream *s = createStream(input, ARRAYSIZE(input), 22050, false);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 22050, false);
+
+		TS_ASSERT_EQUALS(converter->flow(*s, output, ARRAYSIZE(output) / 2, Audio::Mixer::kMaxMixerVolume, 0), 10);
+
+		for (int i = 0; i < ARRAYSIZE(input); i++) {
+			TS_ASSERT_EQUALS(output[i * 2 + 0], input[i]);
+			TS_ASSERT_EQUALS(output[i * 2 + 1], 0);
+		}
+
+		for (int i = ARRAYSIZE(input) * 2; i < ARRAYSIZE(output); i++)
+			TS_ASSERT_EQUALS(output[i], 0);
+
+		delete converter;
+		delete s;
+	}
+
+	void test_simple_saturation() {
+		// Downsampling a constant signal gives the same constant signal
+		const int frames = 700;
+		int16 *input = new int16[frames * 2 * 2];
+		for (int i = 0; i < frames * 2 * 2; i++)
+			input[i] = (i & 1) ? -20000 : 20000;
+
+		int16 *output = new int16[frames * 2];
+		for (int i = 0; i < frames * 2; i++)
+			output[i] = (i & 1) ? -20000 : 20000;
+
+		Audio::AudioStream *s = createStream(input, frames * 2 * 2, 44100, true);
+		Audio::RateConverter *converter = Audio::makeRateConverter(44100, 22050, true);
+
+		TS_ASSERT_EQUALS(converter->flow(*s, output, frames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), frames);
+
+		for (int i = 0; i < frames * 2; i++)
+			TS_ASSERT_EQUALS(output[i], (i & 1) ? -32768 : 32767);
+
+		delete converter;
+		delete s;
+		delete[] output;
+		delete[] input;
+	}
+
+	void test_high_quality_sine() {
+		// Upsampling a sine gives the same sine at the higher rate, after the
+		// filter has settled
+		const int inRate = 11025;
+		const int outRate = 44100;
+		const int frequency = 1000;
+		const int inFrames = inRate / 2;
+		const int outFrames = inFrames * (outRate / inRate) - 256;
+
+		int16 *input = new int16[inFrames];
+		for (int i = 0; i < inFrames; i++)
+			input[i] = (int16)(sin(2 * M_PI * frequency * i / inRate) * 16000);
+
+		int16 *output = new int16[outFrames * 2];
+		memset(output, 0, outFrames * 2 * sizeof(int16));
+
+		Audio::AudioStream *s = createStream(input, inFrames, inRate, false);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, false, Audio::kRateConverterHighQuality);
+
+		TS_ASSERT_EQUALS(converter->flow(*s, output, outFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), outFrames);
+
+		int maxError = 0;
+		for (int i = 64; i < outFrames; i++) {
+			const int expected = (int)(sin(2 * M_PI * frequency * i / outRate) * 16000);
+			maxError = MAX(maxError, ABS(output[i * 2] - expected));
+			TS_ASSERT_EQUALS(output[i * 2], output[i * 2 + 1]);
+		}
+
+		// Less than 0.5% of the amplitude
+		TS_ASSERT_LESS_THAN(maxError, 80);
+
+		delete converter;
+		delete s;
+		delete[] output;
+		delete[] input;
+	}
+
+	void test_high_quality_downsample() {
+		// A constant signal stays constant, even when downsampling
+		const int inFrames = 4000;
+		int16 *input = new int16[inFrames * 2];
+		for (int i = 0; i < inFrames * 2; i++)
+			input[i] = (i & 1) ? -10000 : 12000;
+
+		const int outFrames = inFrames * 22050 / 48000 - 64;
+		int16 *output = new int16[outFrames * 2];
+		memset(output, 0, outFrames * 2 * sizeof(int16));
+
+		Audio::AudioStream *s = createStream(input, inFrames * 2, 48000, true);
+		Audio::RateConverter *converter = Audio::makeRateConverter(48000, 22050, true, Audio::kRateConverterHighQuality);
+
+		TS_ASSERT_EQUALS(converter->flow(*s, output, outFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), outFrames);
+
+		for (int i = 32; i < outFrames; i++) {
+			TS_ASSERT_LESS_THAN_EQUALS(ABS(output[i * 2 + 0] - 12000), 3);
+			TS_ASSERT_LESS_THAN_EQUALS(ABS(output[i * 2 + 1] + 10000), 3);
+		}
+
+		delete converter;
+		delete s;
+		delete[] output;
+		delete[] input;
+	}
+
+	void highQualityLengthTemplate(const bool stereo, const int inRate, const int outRate, const int inFrames) {
+		const int channels = stereo ? 2 : 1;
+
+		int16 *input = new int16[inFrames * channels];
+		for (int i = 0; i < inFrames * channels; i++)
+			input[i] = sample(i);
+
+		// Leave plenty of room, the output ends with the input
+		const int expected = inFrames * outRate / inRate;
+		const int maxFrames = expected + 100;
+		int16 *output = new int16[maxFrames * 2];
+		memset(output, 0, maxFrames * 2 * sizeof(int16));
+
+		Audio::AudioStream *s = createStream(input, inFrames * channels, inRate, stereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, Audio::kRateConverterHighQuality);
+
+		// The last input samples are output as well, in one go or in pieces
+		int done = converter->flow(*s, output, maxFrames / 3, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		done += converter->flow(*s, output + done * 2, maxFrames - done, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(done - expected), 1);
+
+		TS_ASSERT_EQUALS(converter->flow(*s, output, maxFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 0);
+
+		delete converter;
+		delete s;
+		delete[] output;
+		delete[] input;
+	}
+
+	void test_high_quality_length() {
+		highQualityLengthTemplate(false, 11025, 44100, 1000);
+		highQualityLengthTemplate(true, 22050, 48000, 1001);
+		highQualityLengthTemplate(false, 48000, 22050, 3000);
+		highQualityLengthTemplate(true, 44100, 8000, 5000);
+		highQualityLengthTemplate(false, 44100, 8000, 20);
+	}
+};
@@ -0,0 +1,134 @@
+#include <cxxtest/TestSuite.h>
+
+#include "backends/fs/posix/mmapstream.h"
+
+#include <stdio.h>
+
+class MmapStreamTestSuite : public CxxTest::TestSuite {
+	/** Gives access to the constructor, to test on a temporary file */
+	class TestMmapStream : public MmapStream {
+	public:
+		TestMmapStream(FILE *handle) : MmapStream(handle) {}
+	};
+
+	static byte valueAt(uint32 pos) {
+		return (byte)(pos ^ (pos >> 8) ^ (pos >> 16));
+	}
+
+	/** Create a temporary file of the given size, filled with valueAt() */
+	static TestMmapStream *createStream(uint32 size) {
+		FILE *handle = tmpfile();
+		if (!handle)
+			return 0;
+
+		for (uint32 i = 0; i < size; i++)
+			fputc(valueAt(i), handle);
+		rewind(handle);
+
+		return new TestMmapStream(handle);
+	}
+
+	static bool checkData(const byte *data, uint32 pos, uint32 size) {
+		for (uint32 i = 0; i < size; i++)
+			if (data[i] != valueAt(pos + i))
+				return false;
+		return true;
+	}
+
+public:
+	void test_switch_to_mapping() {
+		const uint32 size = 3 * MmapStream::kMinMapSize + 123;
+		TestMmapStream *stream = createStream(size);
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		// Reads through stdio first
+		byte buf[64];
+		TS_ASSERT_EQUALS(stream->read(buf, 10), (uint32)10);
+		TS_ASSERT(checkData(buf, 0, 10));
+		TS_ASSERT(stream->seek(1000));
+		TS_ASSERT_EQUALS(stream->readByte(), valueAt(1000));
+		TS_ASSERT_EQUALS(stream->pos(), 1001);
+
+		// Borrowing maps the file at the position stdio is at
+		const byte *data = stream->borrowData(32);
+		TS_ASSERT(data);
+		if (!data) {
+			delete stream;
+			return;
+		}
+		TS_ASSERT(checkData(data, 1001, 32));
+		TS_ASSERT_EQUALS(stream->pos(), 1033);
+		TS_ASSERT_EQUALS(stream->size(), (int32)size);
+
+		// Reads and seeks carry on from the mapping
+		TS_ASSERT_EQUALS(stream->read(buf, 64), (uint32)64);
+		TS_ASSERT(checkData(buf, 1033, 64));
+		TS_ASSERT(stream->seek(-10, SEEK_END));
+		TS_ASSERT_EQUALS(stream->borrowData(10), data - 1001 + size - 10);
+		TS_ASSERT(!stream->eos());
+
+		// The pointers stay valid while the stream is alive
+		TS_ASSERT(stream->seek(5));
+		TS_ASSERT_EQUALS(stream->borrowData(4), data - 1001 + 5);
+		TS_ASSERT(checkData(data, 1001, 32));
+
+		delete stream;
+	}
+
+	void test_mapped_eos() {
+		const uint32 size = MmapStream::kMinMapSize;
+		TestMmapStream *stream = createStream(size);
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		TS_ASSERT(stream->borrowData(0));
+
+		// Borrowing past the end fails and leaves the position alone
+		TS_ASSERT(stream->seek(-4, SEEK_END));
+		TS_ASSERT(!stream->borrowData(5));
+		TS_ASSERT_EQUALS(stream->pos(), (int32)size - 4);
+		TS_ASSERT(!stream->eos());
+
+		// A read across the end returns what is left, like stdio
+		byte buf[8];
+		TS_ASSERT_EQUALS(stream->read(buf, 8), (uint32)4);
+		TS_ASSERT(checkData(buf, size - 4, 4));
+		TS_ASSERT(stream->eos());
+		TS_ASSERT(!stream->err());
+
+		// Seeking clears the end of stream flag
+		TS_ASSERT(stream->seek(0));
+		TS_ASSERT(!stream->eos());
+		TS_ASSERT_EQUALS(stream->read(buf, 4), (uint32)4);
+		TS_ASSERT(checkData(buf, 0, 4));
+
+		// Seeking before the start fails
+		TS_ASSERT(!stream->seek(-1));
+		TS_ASSERT_EQUALS(stream->pos(), 4);
+
+		delete stream;
+	}
+
+	void test_small_file() {
+		// Small files are not mapped, but read as before
+		const uint32 size = MmapStream::kMinMapSize - 1;
+		TestMmapStream *stream = createStream(size);
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		TS_ASSERT(stream->seek(100));
+		TS_ASSERT(!stream->borrowData(16));
+		TS_ASSERT_EQUALS(stream->pos(), 100);
+
+		byte buf[16];
+		TS_ASSERT_EQUALS(stream->read(buf, 16), (uint32)16);
+		TS_ASSERT(checkData(buf, 100, 16));
+		TS_ASSERT_EQUALS(stream->size(), (int32)size);
+
+		delete stream;
+	}
+};
@@ -149,4 +149,97 @@ class BitStreamTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(bs.peekBits(5), 12u);
 		TS_ASSERT(!bs.eos());
 	}
+
+	void test_cached_get_bits() {
+		byte contents[] = { 'a', 'b' };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		Common::BitStreamCached8MSB bs(ms);
+		TS_ASSERT_EQUALS(bs.pos(), 0u);
+		TS_ASSERT_EQUALS(bs.getBits(3), 3u);
+		TS_ASSERT_EQUALS(bs.pos(), 3u);
+		TS_ASSERT_EQUALS(bs.peekBits(8), 11u);
+		TS_ASSERT_EQUALS(bs.pos(), 3u);
+		TS_ASSERT_EQUALS(bs.getBits(8), 11u);
+		TS_ASSERT_EQUALS(bs.pos(), 11u);
+		TS_ASSERT_EQUALS(bs.getBits(5), 2u);
+		TS_ASSERT(bs.eos());
+
+		bs.rewind();
+		TS_ASSERT_EQUALS(bs.pos(), 0u);
+		TS_ASSERT(!bs.eos());
+		TS_ASSERT_EQUALS(bs.size(), 16u);
+	}
+
+	void test_cached_get_bits_lsb() {
+		byte contents[] = { 'a', 'b' };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		Common::BitStreamCached8LSB bs(ms);
+		TS_ASSERT_EQUALS(bs.pos(), 0u);
+		TS_ASSERT_EQUALS(bs.getBits(3), 1u);
+		TS_ASSERT_EQUALS(bs.pos(), 3u);
+		TS_ASSERT_EQUALS(bs.peekBits(8), 76u);
+		TS_ASSERT_EQUALS(bs.getBits(8), 76u);
+		TS_ASSERT_EQUALS(bs.pos(), 11u);
+		TS_ASSERT_EQUALS(bs.peekBits(5), 12u);
+		TS_ASSERT(!bs.eos());
+	}
+
+	void test_cached_matches_uncached() {
+		byte contents[24];
+		for (uint i = 0; i < sizeof(contents); i++)
+			contents[i] = (i * 37 + 11) & 0xFF;
+
+		Common::MemoryReadStream ms1(contents, sizeof(contents));
+		Common::MemoryReadStream ms2(contents, sizeof(contents));
+
+		Common::BitStream16LEMSB bs1(ms1);
+		Common::BitStreamCached16LEMSB bs2(ms2);
+
+		// Mixed read sizes, crossing value and cache borders
+		const uint8 sizes[] = { 3, 13, 32, 1, 7, 17, 24, 9, 30, 2, 16, 11 };
+		for (uint i = 0; i < ARRAYSIZE(sizes); i++) {
+			TS_ASSERT_EQUALS(bs1.peekBits(sizes[i]), bs2.peekBits(sizes[i]));
+			TS_ASSERT_EQUALS(bs1.getBits(sizes[i]), bs2.getBits(sizes[i]));
+			TS_ASSERT_EQUALS(bs1.pos(), bs2.pos());
+		}
+
+		bs1.skip(7);
+		bs2.skip(7);
+		TS_ASSERT_EQUALS(bs1.getBits(5), bs2.getBits(5));
+		TS_ASSERT_EQUALS(bs1.pos(), bs2.pos());
+		TS_ASSERT_EQUALS(bs1.eos(), bs2.eos());
+	}
+
+	void test_cached_skip_and_align() {
+		byte contents[16];
+		for (uint i = 0; i < sizeof(contents); i++)
+			contents[i] = (i * 91 + 5) & 0xFF;
+
+		Common::MemoryReadStream ms1(contents, sizeof(contents));
+		Common::MemoryReadStream ms2(contents, sizeof(contents));
+
+		Common::BitStream32BELSB bs1(ms1);
+		Common::BitStreamCached32BELSB bs2(ms2);
+
+		bs1.skip(5);
+		bs2.skip(5);
+		TS_ASSERT_EQUALS(bs1.getBits(6), bs2.getBits(6));
+
+		// Skip beyond everything that is cached
+		bs1.skip(70);
+		bs2.skip(70);
+		TS_ASSERT_EQUALS(bs1.pos(), bs2.pos());
+		TS_ASSERT_EQUALS(bs1.getBits(4), bs2.getBits(4));
+
+		bs1.align();
+		bs2.align();
+		TS_ASSERT_EQUALS(bs1.pos(), 96u);
+		TS_ASSERT_EQUALS(bs2.pos(), 96u);
+		TS_ASSERT_EQUALS(bs1.getBits(32), bs2.getBits(32));
+		TS_ASSERT(bs2.eos());
+	}
 };
@@ -141,4 +141,69 @@ class HuffmanTestSuite : public CxxTest::TestSuite {
 		TS_ASSERT_EQUALS(h.getSymbol(bs), expected[5]);
 		TS_ASSERT_EQUALS(h.getSymbol(bs), expected[6]);
 	}
+
+	void test_get_long_codes() {
+
+		/*
+		 * Codes longer than the first level of the lookup table have
+		 * to be resolved through the second level.
+		 *
+		 * Encoding:
+		 * 0=0
+		 * 1=10
+		 * 2=110
+		 * ...
+		 * 10=11111111110
+		 * 11=111111111110
+		 * 12=111111111111
+		 */
+
+		uint32 codeCount = 13;
+		const uint8 lengths[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 12};
+		const uint32 codes[]  = {0x000, 0x002, 0x006, 0x00E, 0x01E, 0x03E, 0x07E,
+		                         0x0FE, 0x1FE, 0x3FE, 0x7FE, 0xFFE, 0xFFF};
+
+		Common::Huffman h(0, codeCount, codes, lengths, 0);
+
+		/*
+		 * 111111111111 0 1111111110 1110 111111111110 11111111110 000000
+		 *  = 12 0 9 3 11 10 0 0 0 0 0 0
+		 */
+		byte input[] = {0xFF, 0xF7, 0xFD, 0xDF, 0xFD, 0xFF, 0x80};
+		uint32 expected[] = {12, 0, 9, 3, 11, 10, 0, 0, 0, 0, 0, 0};
+
+		Common::MemoryReadStream ms(input, sizeof(input));
+		Common::BitStream8MSB bs(ms);
+
+		for (uint i = 0; i < ARRAYSIZE(expected); i++)
+			TS_ASSERT_EQUALS(h.getSymbol(bs), expected[i]);
+
+		TS_ASSERT(bs.eos());
+	}
+
+	void test_get_long_codes_lsb() {
+
+		/*
+		 * The same as test_get_long_codes, but with the codes read
+		 * from LSB to MSB, so every code is bit-reversed.
+		 */
+
+		uint32 codeCount = 13;
+		const uint8 lengths[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 12};
+		const uint32 codes[]  = {0x000, 0x001, 0x003, 0x007, 0x00F, 0x01F, 0x03F,
+		                         0x07F, 0x0FF, 0x1FF, 0x3FF, 0x7FF, 0xFFF};
+
+		Common::Huffman h(0, codeCount, codes, lengths, 0);
+
+		byte input[] = {0xFF, 0xEF, 0xBF, 0xFB, 0xBF, 0xFF, 0x01};
+		uint32 expected[] = {12, 0, 9, 3, 11, 10, 0, 0, 0, 0, 0, 0};
+
+		Common::MemoryReadStream ms(input, sizeof(input));
+		Common::BitStream8LSB bs(ms);
+
+		for (uint i = 0; i < ARRAYSIZE(expected); i++)
+			TS_ASSERT_EQUALS(h.getSymbol(bs), expected[i]);
+
+		TS_ASSERT(bs.eos());
+	}
 };
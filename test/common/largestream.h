@@ -0,0 +1,221 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/file.h"
+#include "common/memstream.h"
+#include "common/bufferedstream.h"
+#include "common/substream.h"
+
+/**
+ * A read-only stream of arbitrary size whose contents are computed from
+ * the position, so streams beyond 4 GB can be tested without backing data.
+ */
+class LargePatternStream : public Common::SeekableReadStream {
+	int64 _size;
+	int64 _pos;
+	bool _eos;
+
+public:
+	LargePatternStream(int64 size) : _size(size), _pos(0), _eos(false) {}
+
+	static byte valueAt(int64 pos) {
+		return (byte)(pos ^ (pos >> 8) ^ (pos >> 24) ^ (pos >> 32));
+	}
+
+	bool eos() const { return _eos; }
+	void clearErr() { _eos = false; }
+
+	int32 pos() const { return narrowTo32(_pos); }
+	int32 size() const { return narrowTo32(_size); }
+	bool seek(int32 offset, int whence = SEEK_SET) { return seek64(offset, whence); }
+
+	int64 pos64() const { return _pos; }
+	int64 size64() const { return _size; }
+
+	bool seek64(int64 offset, int whence = SEEK_SET) {
+		if (whence == SEEK_CUR)
+			offset += _pos;
+		else if (whence == SEEK_END)
+			offset += _size;
+
+		if (offset < 0 || offset > _size)
+			return false;
+
+		_pos = offset;
+		_eos = false;
+		return true;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		if (dataSize > _size - _pos) {
+			dataSize = _size - _pos;
+			_eos = true;
+		}
+
+		for (uint32 i = 0; i < dataSize; ++i)
+			((byte *)dataPtr)[i] = valueAt(_pos + i);
+
+		_pos += dataSize;
+		return dataSize;
+	}
+};
+
+/**
+ * A file which is embedded at an offset in a container file, remapping
+ * only the 32-bit pos(), size() and seek() like Scumm::ScummFile does.
+ */
+class EmbeddedFile : public Common::File {
+	int32 _start;
+	int32 _len;
+
+public:
+	EmbeddedFile(int32 start, int32 len) : _start(start), _len(len) {}
+
+	int32 pos() const { return File::pos() - _start; }
+	int32 size() const { return _len; }
+
+	bool seek(int32 offs, int whence = SEEK_SET) {
+		if (whence == SEEK_SET)
+			offs += _start;
+		else if (whence == SEEK_END)
+			offs += _start + _len;
+		else
+			offs += File::pos();
+
+		return File::seek(offs, SEEK_SET);
+	}
+};
+
+class LargeStreamTestSuite : public CxxTest::TestSuite {
+	static bool checkRead(Common::SeekableReadStream &stream, int64 expectedPos, uint32 len) {
+		byte buf[64];
+		assert(len <= sizeof(buf));
+
+		if (stream.read(buf, len) != len)
+			return false;
+
+		for (uint32 i = 0; i < len; ++i) {
+			if (buf[i] != LargePatternStream::valueAt(expectedPos + i))
+				return false;
+		}
+		return true;
+	}
+
+	public:
+	void test_compat_layer() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		TS_ASSERT_EQUALS(ms.size64(), 7);
+		TS_ASSERT(ms.seek64(3));
+		TS_ASSERT_EQUALS(ms.pos64(), 3);
+		TS_ASSERT_EQUALS(ms.readByte(), 4);
+
+		// Offsets beyond the 32-bit range are refused, not truncated
+		TS_ASSERT(!ms.seek64(0x100000003LL));
+		TS_ASSERT_EQUALS(ms.pos(), 4);
+	}
+
+	void test_pattern_stream() {
+		LargePatternStream ps(0x140000000LL);
+
+		TS_ASSERT_EQUALS(ps.size(), -1);
+		TS_ASSERT_EQUALS(ps.size64(), 0x140000000LL);
+
+		TS_ASSERT(ps.seek64(0x7FFFFFF0LL));
+		TS_ASSERT_EQUALS(ps.pos(), 0x7FFFFFF0);
+		TS_ASSERT(checkRead(ps, 0x7FFFFFF0LL, 32));
+		TS_ASSERT_EQUALS(ps.pos(), -1);
+		TS_ASSERT_EQUALS(ps.pos64(), 0x80000010LL);
+	}
+
+	void test_sub_stream_across_4gb() {
+		LargePatternStream ps(0x140000000LL);
+
+		const int64 begin = 0xFFFFFFE0LL, end = 0x100000040LL;
+		Common::SeekableSubReadStream ssrs(&ps, begin, end);
+
+		TS_ASSERT_EQUALS(ssrs.size(), 0x60);
+		TS_ASSERT(checkRead(ssrs, begin, 64));
+		TS_ASSERT_EQUALS(ssrs.pos(), 64);
+
+		ssrs.seek(-8, SEEK_END);
+		TS_ASSERT(checkRead(ssrs, end - 8, 8));
+		TS_ASSERT(!ssrs.eos());
+		ssrs.readByte();
+		TS_ASSERT(ssrs.eos());
+	}
+
+	void test_sub_stream_beyond_2gb() {
+		LargePatternStream ps(0x140000000LL);
+
+		const int64 begin = 0x10LL, end = 0x120000000LL;
+		Common::SeekableSubReadStream ssrs(&ps, begin, end);
+
+		TS_ASSERT_EQUALS(ssrs.size(), -1);
+		TS_ASSERT_EQUALS(ssrs.size64(), end - begin);
+
+		TS_ASSERT(ssrs.seek64(0x7FFFFFFFLL));
+		TS_ASSERT(checkRead(ssrs, begin + 0x7FFFFFFFLL, 2));
+		TS_ASSERT_EQUALS(ssrs.pos(), -1);
+
+		TS_ASSERT(ssrs.seek64(0xFFFFFFF8LL));
+		TS_ASSERT(ssrs.seek(16, SEEK_CUR));
+		TS_ASSERT_EQUALS(ssrs.pos64(), 0x100000008LL);
+		TS_ASSERT(checkRead(ssrs, begin + 0x100000008LL, 16));
+	}
+
+	void test_buffered_across_2gb_and_4gb() {
+		LargePatternStream ps(0x140000000LL);
+
+		Common::SeekableReadStream *bs = Common::wrapBufferedSeekableReadStream(&ps, 32, DisposeAfterUse::NO);
+
+		TS_ASSERT_EQUALS(bs->size64(), 0x140000000LL);
+
+		TS_ASSERT(bs->seek64(0x7FFFFFF8LL));
+		TS_ASSERT(checkRead(*bs, 0x7FFFFFF8LL, 16));
+		TS_ASSERT_EQUALS(bs->pos64(), 0x80000008LL);
+
+		// A local seek back across the 2 GB boundary stays in the buffer
+		TS_ASSERT(bs->seek(-12, SEEK_CUR));
+		TS_ASSERT_EQUALS(bs->pos64(), 0x7FFFFFFCLL);
+		TS_ASSERT(checkRead(*bs, 0x7FFFFFFCLL, 8));
+
+		TS_ASSERT(bs->seek64(0xFFFFFFFCLL));
+		TS_ASSERT(checkRead(*bs, 0xFFFFFFFCLL, 8));
+		TS_ASSERT_EQUALS(bs->pos64(), 0x100000004LL);
+
+		TS_ASSERT(bs->seek64(-4, SEEK_END));
+		TS_ASSERT(checkRead(*bs, 0x13FFFFFFCLL, 4));
+
+		delete bs;
+	}
+
+	void test_sub_stream_of_embedded_file() {
+		byte contents[64];
+		for (int i = 0; i < 64; ++i)
+			contents[i] = i;
+
+		EmbeddedFile file(16, 32);
+		file.open(new Common::MemoryReadStream(contents, sizeof(contents)), "container");
+
+		TS_ASSERT_EQUALS(file.size64(), 32);
+		TS_ASSERT(file.seek64(4));
+		TS_ASSERT_EQUALS(file.pos64(), 4);
+		TS_ASSERT_EQUALS(file.readByte(), 20);
+
+		// The substream must address the embedded file, not the container
+		Common::SeekableSubReadStream ssrs(&file, 8, 24);
+		TS_ASSERT_EQUALS(ssrs.readByte(), 24);
+		TS_ASSERT(ssrs.seek(-1, SEEK_END));
+		TS_ASSERT_EQUALS(ssrs.readByte(), 39);
+
+		Common::SeekableReadStream *bs = Common::wrapBufferedSeekableReadStream(&file, 8, DisposeAfterUse::NO);
+		TS_ASSERT_EQUALS(bs->size64(), 32);
+		TS_ASSERT(bs->seek(10));
+		TS_ASSERT_EQUALS(bs->readByte(), 26);
+		TS_ASSERT(bs->seek64(-2, SEEK_END));
+		TS_ASSERT_EQUALS(bs->readByte(), 46);
+		TS_ASSERT_EQUALS(bs->pos64(), 31);
+		delete bs;
+	}
+};
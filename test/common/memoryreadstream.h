@@ -104,4 +104,22 @@ class MemoryReadStreamTestSuite : public CxxTest::TestSuite {
 		ms.seek(0, SEEK_SET);
 		TS_ASSERT(!ms.eos());
 	}
+
+	void test_borrow_data() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		ms.seek(2, SEEK_SET);
+		const byte *ptr = ms.borrowData(3);
+		TS_ASSERT_EQUALS(ptr, contents + 2);
+		TS_ASSERT_EQUALS(ms.pos(), 5);
+		TS_ASSERT(!ms.eos());
+
+		// Borrowing past the end fails and leaves the position alone
+		TS_ASSERT(!ms.borrowData(3));
+		TS_ASSERT_EQUALS(ms.pos(), 5);
+
+		TS_ASSERT_EQUALS(ms.borrowData(2), contents + 5);
+		TS_ASSERT_EQUALS(ms.pos(), 7);
+	}
 };
@@ -0,0 +1,145 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/readaheadstream.h"
+
+class ReadAheadStreamTestSuite : public CxxTest::TestSuite {
+	public:
+	void test_traverse() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, 10);
+		Common::ReadAheadStream ras(&ms, DisposeAfterUse::NO, 4, 2);
+
+		byte i, b;
+		for (i = 0; i < 10; ++i) {
+			TS_ASSERT(!ras.eos());
+
+			TS_ASSERT_EQUALS(i, ras.pos());
+
+			ras.read(&b, 1);
+			TS_ASSERT_EQUALS(i, b);
+		}
+
+		TS_ASSERT(!ras.eos());
+
+		TS_ASSERT_EQUALS((uint)0, ras.read(&b, 1));
+		TS_ASSERT(ras.eos());
+	}
+
+	void test_fill() {
+		byte contents[20];
+		for (int i = 0; i < 20; ++i)
+			contents[i] = i;
+		Common::MemoryReadStream ms(contents, 20);
+		Common::ReadAheadStream ras(&ms, DisposeAfterUse::NO, 4, 3);
+
+		// Only as many blocks as fit are read ahead
+		TS_ASSERT(ras.fillNextBlock());
+		TS_ASSERT(ras.fillNextBlock());
+		TS_ASSERT(ras.fillNextBlock());
+		TS_ASSERT(!ras.fillNextBlock());
+		TS_ASSERT_EQUALS(ms.pos(), 12);
+		TS_ASSERT_EQUALS(ras.pos(), 0);
+
+		// Reading a whole block makes room for another one
+		byte buf[6];
+		TS_ASSERT_EQUALS(ras.read(buf, 6), (uint32)6);
+		TS_ASSERT_EQUALS(buf[5], 5);
+		TS_ASSERT_EQUALS(ms.pos(), 12);
+		TS_ASSERT(ras.fillNextBlock());
+		TS_ASSERT(!ras.fillNextBlock());
+		TS_ASSERT_EQUALS(ms.pos(), 16);
+	}
+
+	void test_seek_into_blocks() {
+		byte contents[20];
+		for (int i = 0; i < 20; ++i)
+			contents[i] = i;
+		Common::MemoryReadStream ms(contents, 20);
+		Common::ReadAheadStream ras(&ms, DisposeAfterUse::NO, 4, 3);
+
+		while (ras.fillNextBlock())
+			;
+
+		// Seeking forward and back within the blocks read ahead does not
+		// read the parent stream again
+		TS_ASSERT(ras.seek(9));
+		TS_ASSERT_EQUALS(ras.pos(), 9);
+		TS_ASSERT_EQUALS(ras.readByte(), 9);
+		TS_ASSERT(ras.seek(-2, SEEK_CUR));
+		TS_ASSERT_EQUALS(ras.readByte(), 8);
+		TS_ASSERT_EQUALS(ms.pos(), 12);
+
+		// The data up to the end of the blocks read ahead is still there
+		TS_ASSERT(ras.seek(12));
+		TS_ASSERT_EQUALS(ms.pos(), 12);
+		TS_ASSERT_EQUALS(ras.readByte(), 12);
+		TS_ASSERT_EQUALS(ms.pos(), 16);
+
+		// The blocks before the seek position were dropped
+		TS_ASSERT(ras.seek(2));
+		TS_ASSERT_EQUALS(ras.readByte(), 2);
+		TS_ASSERT_EQUALS(ms.pos(), 6);
+	}
+
+	void test_seek_past_blocks() {
+		byte contents[20];
+		for (int i = 0; i < 20; ++i)
+			contents[i] = i;
+		Common::MemoryReadStream ms(contents, 20);
+		Common::ReadAheadStream ras(&ms, DisposeAfterUse::NO, 4, 3);
+
+		TS_ASSERT(ras.fillNextBlock());
+		TS_ASSERT_EQUALS(ms.pos(), 4);
+
+		// Seeking beyond the data read ahead restarts reading there
+		TS_ASSERT(ras.seek(13));
+		TS_ASSERT_EQUALS(ras.pos(), 13);
+		TS_ASSERT(ras.fillNextBlock());
+		TS_ASSERT_EQUALS(ms.pos(), 17);
+
+		byte buf[5];
+		TS_ASSERT_EQUALS(ras.read(buf, 5), (uint32)5);
+		for (int i = 0; i < 5; ++i)
+			TS_ASSERT_EQUALS(buf[i], 13 + i);
+		TS_ASSERT_EQUALS(ras.pos(), 18);
+		TS_ASSERT(!ras.eos());
+
+		TS_ASSERT(!ras.seek(21));
+		TS_ASSERT(!ras.seek(-1));
+		TS_ASSERT_EQUALS(ras.pos(), 18);
+	}
+
+	void test_read_at_eos() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, 10);
+		Common::ReadAheadStream ras(&ms, DisposeAfterUse::NO, 4, 4);
+
+		while (ras.fillNextBlock())
+			;
+		TS_ASSERT(!ras.eos());
+
+		// A read across the end returns what is left
+		byte buf[4];
+		TS_ASSERT(ras.seek(8));
+		TS_ASSERT_EQUALS(ras.read(buf, 4), (uint32)2);
+		TS_ASSERT_EQUALS(buf[1], 9);
+		TS_ASSERT(ras.eos());
+		TS_ASSERT(!ras.err());
+
+		TS_ASSERT_EQUALS(ras.read(buf, 4), (uint32)0);
+		TS_ASSERT(ras.eos());
+		TS_ASSERT_EQUALS(ras.pos(), 10);
+
+		// Seeking clears the end of stream flag
+		TS_ASSERT(ras.seek(0, SEEK_END));
+		TS_ASSERT(!ras.eos());
+		TS_ASSERT(!ras.fillNextBlock());
+		TS_ASSERT_EQUALS(ras.read(buf, 1), (uint32)0);
+		TS_ASSERT(ras.eos());
+
+		TS_ASSERT(ras.seek(-1, SEEK_END));
+		TS_ASSERT_EQUALS(ras.readByte(), 9);
+		TS_ASSERT(!ras.eos());
+	}
+};
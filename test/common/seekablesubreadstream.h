@@ -70,4 +70,22 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_borrow_data() {
+		byte contents[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+		Common::MemoryReadStream ms(contents, 10);
+
+		int start = 2, end = 8;
+
+		Common::SeekableSubReadStream ssrs(&ms, start, end);
+
+		ssrs.seek(1, SEEK_SET);
+		TS_ASSERT_EQUALS(ssrs.borrowData(4), contents + 3);
+		TS_ASSERT_EQUALS(ssrs.pos(), 5);
+
+		// The substream must not hand out data beyond its own end
+		TS_ASSERT(!ssrs.borrowData(2));
+		TS_ASSERT_EQUALS(ssrs.pos(), 5);
+		TS_ASSERT_EQUALS(ssrs.readByte(), 8);
+	}
 };
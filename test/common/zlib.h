@@ -0,0 +1,101 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/zlib.h"
+
+#if defined(USE_ZLIB)
+
+class ZlibTestSuite : public CxxTest::TestSuite {
+	enum {
+		kDataSize = 3 * 1024 * 1024 + 1234
+	};
+
+	static byte dataAt(uint32 pos) {
+		// Compressible, but without long repeats
+		return (byte)((pos >> 7) ^ (pos * 13 >> 11) ^ (pos % 251));
+	}
+
+	byte *compress(uint32 &compressedSize) {
+		Common::MemoryWriteStreamDynamic *memory = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(memory);
+
+		byte buf[4096];
+		for (uint32 pos = 0; pos < kDataSize; pos += sizeof(buf)) {
+			uint32 len = MIN<uint32>(sizeof(buf), kDataSize - pos);
+			for (uint32 i = 0; i < len; i++)
+				buf[i] = dataAt(pos + i);
+			gzip->write(buf, len);
+		}
+
+		gzip->finalize();
+		byte *data = memory->getData();
+		compressedSize = memory->size();
+		delete gzip;
+		return data;
+	}
+
+	bool checkRead(Common::SeekableReadStream &stream, uint32 pos, uint32 len) {
+		if (!stream.seek(pos) || (uint32)stream.pos() != pos)
+			return false;
+
+		for (uint32 i = 0; i < len; i++) {
+			if (stream.readByte() != dataAt(pos + i))
+				return false;
+		}
+
+		return (uint32)stream.pos() == pos + len;
+	}
+
+	void checkSeeking(Common::SeekableReadStream &stream) {
+		TS_ASSERT_EQUALS(stream.size(), kDataSize);
+
+		// Read everything once, then jump around, forward and backward
+		TS_ASSERT(checkRead(stream, 0, kDataSize));
+		TS_ASSERT(checkRead(stream, 2500000, 1000));
+		TS_ASSERT(checkRead(stream, 100, 1000));
+		TS_ASSERT(checkRead(stream, 1500000, 70000));
+		TS_ASSERT(checkRead(stream, 1048570, 20));
+		TS_ASSERT(checkRead(stream, kDataSize - 10, 10));
+
+		byte b;
+		TS_ASSERT_EQUALS(stream.read(&b, 1), (uint32)0);
+		TS_ASSERT(stream.eos());
+		TS_ASSERT(!stream.err());
+	}
+
+	void checkSeekingAhead(Common::SeekableReadStream &stream) {
+		// Seeking into data which was never read decompresses up to it
+		TS_ASSERT(checkRead(stream, 2000000, 100));
+		TS_ASSERT(checkRead(stream, 10, 100));
+		TS_ASSERT(checkRead(stream, 2100000, 100));
+		TS_ASSERT(!stream.err());
+	}
+
+public:
+	void test_gzip_seek() {
+		uint32 size;
+		byte *data = compress(size);
+
+		Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(new Common::MemoryReadStream(data, size, DisposeAfterUse::YES));
+		checkSeeking(*stream);
+		delete stream;
+	}
+
+	void test_deflate_seek() {
+		uint32 size;
+		byte *data = compress(size);
+
+		// Strip the gzip header and trailer to get the raw deflate data
+		Common::SeekableReadStream *stream = Common::wrapDeflateReadStream(new Common::MemoryReadStream(data + 10, size - 18), kDataSize);
+		checkSeeking(*stream);
+		delete stream;
+
+		stream = Common::wrapDeflateReadStream(new Common::MemoryReadStream(data + 10, size - 18), kDataSize);
+		checkSeekingAhead(*stream);
+		delete stream;
+
+		free(data);
+	}
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/util.h"
+#include "graphics/transparent_surface.h"
+
+class TransparentSurfaceTestSuite : public CxxTest::TestSuite {
+	struct Channels {
+		int a, r, g, b;
+	};
+
+	static Channels split(uint32 pixel) {
+		Channels c;
+		c.a = pixel & 0xFF;
+		c.b = (pixel >> 8) & 0xFF;
+		c.g = (pixel >> 16) & 0xFF;
+		c.r = pixel >> 24;
+		return c;
+	}
+
+	static uint32 join(const Channels &c) {
+		return ((uint32)c.r << 24) | (c.g << 16) | (c.b << 8) | c.a;
+	}
+
+	/** The blending of a single pixel, done the way the scalar blitters do it */
+	static uint32 referencePixel(Graphics::TSpriteBlendMode blendMode, uint32 color, uint32 inPixel, uint32 outPixel) {
+		const Channels in = split(inPixel);
+		Channels out = split(outPixel);
+		const int ca = (color >> 24) & 0xFF, cr = (color >> 16) & 0xFF, cg = (color >> 8) & 0xFF, cb = color & 0xFF;
+
+		if (blendMode == Graphics::BLEND_NORMAL) {
+			if (color == 0xFFFFFFFF) {
+				if (in.a != 0) {
+					out.a = 255;
+					out.r = (in.r * in.a + out.r * (255 - in.a)) >> 8;
+					out.g = (in.g * in.a + out.g * (255 - in.a)) >> 8;
+					out.b = (in.b * in.a + out.b * (255 - in.a)) >> 8;
+				}
+			} else {
+				uint32 ina = in.a * ca >> 8;
+				out.a = 255;
+				out.b = (out.b * (255 - ina) >> 8) + (in.b * ina * cb >> 16);
+				out.g = (out.g * (255 - ina) >> 8) + (in.g * ina * cg >> 16);
+				out.r = (out.r * (255 - ina) >> 8) + (in.r * ina * cr >> 16);
+			}
+		} else if (blendMode == Graphics::BLEND_ADDITIVE) {
+			if (color == 0xFFFFFFFF) {
+				if (in.a != 0) {
+					out.r = MIN((in.r * in.a >> 8) + out.r, 255);
+					out.g = MIN((in.g * in.a >> 8) + out.g, 255);
+					out.b = MIN((in.b * in.a >> 8) + out.b, 255);
+				}
+			} else {
+				uint32 ina = in.a * ca >> 8;
+				out.b = MIN<uint>(out.b + (cb != 255 ? (in.b * cb * ina) >> 16 : in.b * ina >> 8), 255u);
+				out.g = MIN<uint>(out.g + (cg != 255 ? (in.g * cg * ina) >> 16 : in.g * ina >> 8), 255u);
+				out.r = MIN<uint>(out.r + (cr != 255 ? (in.r * cr * ina) >> 16 : in.r * ina >> 8), 255u);
+			}
+		} else {
+			if (color == 0xFFFFFFFF) {
+				if (in.a != 0) {
+					out.r = MAX(out.r - ((in.r * out.r) * in.a >> 16), 0);
+					out.g = MAX(out.g - ((in.g * out.g) * in.a >> 16), 0);
+					out.b = MAX(out.b - ((in.b * out.b) * in.a >> 16), 0);
+				}
+			} else {
+				out.a = 255;
+				out.b = MAX(out.b - (cb != 255 ? (int)(((uint32)in.b * cb * out.b * in.a) >> 24) : in.b * out.b * in.a >> 16), 0);
+				out.g = MAX(out.g - (cg != 255 ? (int)(((uint32)in.g * cg * out.g * in.a) >> 24) : in.g * out.g * in.a >> 16), 0);
+				out.r = MAX(out.r - (cr != 255 ? (int)(((uint32)in.r * cr * out.r * in.a) >> 24) : in.r * out.r * in.a >> 16), 0);
+			}
+		}
+
+		return join(out);
+	}
+
+	/** Fill a surface with random pixels, with runs of transparent and opaque ones */
+	static void fillSurface(Graphics::Surface &surface, uint32 seed) {
+		for (int y = 0; y < surface.getHeight(); y++) {
+			uint32 *row = (uint32 *)surface.getBasePtr(0, y);
+			for (int x = 0; x < surface.getWidth(); x++) {
+				seed = seed * 1103515245 + 12345;
+				uint32 pixel = (seed >> 16) | ((seed * 69069) & 0xFFFF0000);
+				if ((x & 15) < 3)
+					pixel = (pixel & ~0xFF) | ((x & 1) ? 0xFF : 0);
+				row[x] = pixel;
+			}
+		}
+	}
+
+	/**
+	 * Blit a random image onto a random target, and compare the result to
+	 * the reference blending.
+	 */
+	static bool checkBlit(Graphics::TSpriteBlendMode blendMode, uint32 color, int flipping, int width, uint32 seed) {
+		const int height = 3;
+		const Graphics::PixelFormat format = Graphics::TransparentSurface::getSupportedPixelFormat();
+
+		Graphics::TransparentSurface source;
+		source.create(width, height, format);
+		fillSurface(source, seed);
+
+		// Leave a border around the blit, which must not be touched
+		Graphics::Surface target;
+		target.create(width + 2, height, format);
+		fillSurface(target, seed + 1);
+
+		Graphics::Surface expected;
+		expected.copyFrom(target);
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				int sx = (flipping & Graphics::FLIP_H) ? width - 1 - x : x;
+				int sy = (flipping & Graphics::FLIP_V) ? height - 1 - y : y;
+				uint32 *out = (uint32 *)expected.getBasePtr(x + 1, y);
+				*out = referencePixel(blendMode, color, *(const uint32 *)source.getBasePtr(sx, sy), *out);
+			}
+		}
+
+		source.blit(target, 1, 0, flipping, 0, color, -1, -1, blendMode);
+
+		return memcmp(target.getPixels(), expected.getPixels(), target.getPitch() * height) == 0;
+	}
+
+	static void checkBlendMode(Graphics::TSpriteBlendMode blendMode) {
+		// Widths cover both whole blocks of four pixels and leftovers
+		static const int widths[] = { 1, 3, 4, 5, 7, 8, 13, 37 };
+		static const uint32 colors[] = { 0xFFFFFFFF, 0xFF80FF40, 0x7FFFFFFF, 0xC0FF2010, 0x01FFFFFF };
+
+		for (int i = 0; i < ARRAYSIZE(widths); i++) {
+			for (int j = 0; j < ARRAYSIZE(colors); j++) {
+				for (int flipping = 0; flipping <= Graphics::FLIP_HV; flipping++)
+					TS_ASSERT(checkBlit(blendMode, colors[j], flipping, widths[i], i * 31 + j * 7 + flipping));
+			}
+		}
+	}
+
+public:
+	void test_alpha_blend() {
+		checkBlendMode(Graphics::BLEND_NORMAL);
+	}
+
+	void test_additive_blend() {
+		checkBlendMode(Graphics::BLEND_ADDITIVE);
+	}
+
+	void test_subtractive_blend() {
+		checkBlendMode(Graphics::BLEND_SUBTRACTIVE);
+	}
+};
@@ -0,0 +1,150 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/util.h"
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite {
+	/** The conversion of a single pixel, done the way the lookup tables are built */
+	static uint32 referencePixel(const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale, byte y, byte u, byte v) {
+		int16 cr = v - 128, cb = u - 128;
+		int r = y + (int16)((0.419 / 0.299) * cr);
+		int g = y + (int16)(-(0.299 / 0.419) * cr) + (int16)(-(0.114 / 0.331) * cb);
+		int b = y + (int16)((0.587 / 0.331) * cb);
+
+		if (scale == Graphics::YUVToRGBManager::kScaleFull) {
+			r = CLIP(r, 0, 255);
+			g = CLIP(g, 0, 255);
+			b = CLIP(b, 0, 255);
+		} else {
+			r = (CLIP(r, 16, 235) - 16) * 255 / 219;
+			g = (CLIP(g, 16, 235) - 16) * 255 / 219;
+			b = (CLIP(b, 16, 235) - 16) * 255 / 219;
+		}
+
+		return format.RGBToColor(r, g, b);
+	}
+
+	static uint32 getPixel(const Graphics::Surface &surface, int x, int y) {
+		if (surface.getFormat().bytesPerPixel == 2)
+			return *(const uint16 *)surface.getBasePtr(x, y);
+		return *(const uint32 *)surface.getBasePtr(x, y);
+	}
+
+	/** Fill a plane with a pattern covering all values, with some runs of extreme ones */
+	static void fillPlane(byte *plane, int size, uint32 seed) {
+		for (int i = 0; i < size; i++) {
+			seed = seed * 1103515245 + 12345;
+			byte value = seed >> 16;
+			if ((i & 63) < 8)
+				value = (value & 1) ? 255 : 0;
+			plane[i] = value;
+		}
+	}
+
+	/**
+	 * Convert a picture with the given chroma subsampling, and compare it
+	 * to the reference conversion.
+	 */
+	static bool checkConversion(const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale, int subsampling, int width, int height) {
+		const int yPitch = width + 5;
+		const int uvWidth = width / subsampling + 1, uvHeight = height / subsampling + 1;
+		const int uvPitch = uvWidth + 3;
+
+		byte *y = new byte[yPitch * height];
+		byte *u = new byte[uvPitch * uvHeight];
+		byte *v = new byte[uvPitch * uvHeight];
+		fillPlane(y, yPitch * height, 1);
+		fillPlane(u, uvPitch * uvHeight, 2);
+		fillPlane(v, uvPitch * uvHeight, 3);
+
+		// 410 interpolates the chroma, so give it the same value within every row
+		if (subsampling == 4) {
+			for (int i = 0; i < uvHeight; i++) {
+				memset(u + i * uvPitch, u[i * uvPitch], uvPitch);
+				memset(v + i * uvPitch, v[i * uvPitch], uvPitch);
+			}
+		}
+
+		Graphics::Surface surface;
+		surface.create(width, height, format);
+		memset(surface.getPixels(), 0x5A, surface.getPitch() * height);
+
+		if (subsampling == 1)
+			YUVToRGBMan.convert444(&surface, scale, y, u, v, width, height, yPitch, uvPitch);
+		else if (subsampling == 2)
+			YUVToRGBMan.convert420(&surface, scale, y, u, v, width, height, yPitch, uvPitch);
+		else
+			YUVToRGBMan.convert410(&surface, scale, y, u, v, width, height, yPitch, uvPitch);
+
+		bool matches = true;
+		for (int row = 0; row < height && matches; row++) {
+			for (int col = 0; col < width; col++) {
+				// 410 leaves the columns which do not fill a chroma block untouched
+				if (subsampling == 4 && col >= (width & ~3)) {
+					if (getPixel(surface, col, row) != (format.bytesPerPixel == 2 ? 0x5A5Au : 0x5A5A5A5Au)) {
+						matches = false;
+						break;
+					}
+					continue;
+				}
+
+				// 410 interpolates between this chroma row and the next one
+				int uvIndex = (row / subsampling) * uvPitch + col / subsampling;
+				byte uValue = u[uvIndex], vValue = v[uvIndex];
+				if (subsampling == 4) {
+					int yDiff = row & 3;
+					uValue = (u[uvIndex] * (4 - yDiff) * 4 + u[uvIndex + uvPitch] * yDiff * 4) >> 4;
+					vValue = (v[uvIndex] * (4 - yDiff) * 4 + v[uvIndex + uvPitch] * yDiff * 4) >> 4;
+				}
+
+				if (getPixel(surface, col, row) != referencePixel(format, scale, y[row * yPitch + col], uValue, vValue)) {
+					matches = false;
+					break;
+				}
+			}
+		}
+
+		delete[] y;
+		delete[] u;
+		delete[] v;
+		return matches;
+	}
+
+	static void checkAllSubsamplings(const Graphics::PixelFormat &format) {
+		// Widths cover both whole blocks of eight pixels and leftovers
+		static const int widths[] = { 4, 8, 12, 36, 64 };
+
+		for (int scale = 0; scale < 2; scale++) {
+			Graphics::YUVToRGBManager::LuminanceScale s = scale ? Graphics::YUVToRGBManager::kScaleITU : Graphics::YUVToRGBManager::kScaleFull;
+
+			for (int i = 0; i < ARRAYSIZE(widths); i++) {
+				TS_ASSERT(checkConversion(format, s, 1, widths[i], 8));
+				TS_ASSERT(checkConversion(format, s, 2, widths[i], 8));
+				TS_ASSERT(checkConversion(format, s, 4, widths[i], 8));
+			}
+
+			// 410 takes any width
+			TS_ASSERT(checkConversion(format, s, 4, 13, 8));
+			TS_ASSERT(checkConversion(format, s, 4, 38, 8));
+			TS_ASSERT(checkConversion(format, s, 4, 3, 4));
+		}
+	}
+
+public:
+	void test_rgb565() {
+		checkAllSubsamplings(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+	}
+
+	void test_argb1555() {
+		checkAllSubsamplings(Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15));
+	}
+
+	void test_rgba8888() {
+		checkAllSubsamplings(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+	}
+
+	void test_xbgr8888() {
+		checkAllSubsamplings(Graphics::PixelFormat(4, 8, 8, 8, 0, 0, 8, 16, 24));
+	}
+};
@@ -0,0 +1,335 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/bitstream.h"
+#include "common/memstream.h"
+#include "video/smk_huffman.h"
+
+class SmackerHuffmanTestSuite : public CxxTest::TestSuite {
+	class BitWriter {
+	public:
+		BitWriter() : _bits(0) {}
+
+		void putBit(uint32 bit) {
+			if ((_bits & 7) == 0)
+				_data.push_back(0);
+			if (bit)
+				_data.back() |= 1 << (_bits & 7);
+			_bits++;
+		}
+
+		/** Write the lowest n bits of value, least significant first */
+		void putBits(uint32 value, int n) {
+			for (int i = 0; i < n; i++)
+				putBit((value >> i) & 1);
+		}
+
+		const Common::Array<byte> &getData() const { return _data; }
+
+	private:
+		Common::Array<byte> _data;
+		uint32 _bits;
+	};
+
+	class Random {
+	public:
+		Random(uint32 seed) : _seed(seed) {}
+
+		uint32 next(uint32 max) {
+			_seed = _seed * 1103515245 + 12345;
+			return (_seed >> 8) % max;
+		}
+
+	private:
+		uint32 _seed;
+	};
+
+	struct Node {
+		int child[2]; ///< -1 for leaves
+		uint32 value;
+	};
+
+	struct Leaf {
+		uint32 code; ///< The first bit is the lowest one
+		int length;
+		uint32 value;
+	};
+
+	/**
+	 * A tree in the form BigHuffmanTree reads it, along with a plain
+	 * decoder which walks the tree bit by bit, as the decoder did before
+	 * it used a prefix table.
+	 */
+	struct Tree {
+		Common::Array<Node> nodes;
+		uint32 markers[3];
+
+		Common::Array<Leaf> leaves;
+		Common::Array<uint32> slots;
+		int last[3];
+
+		/** Assign the leaves their codes, and the escape markers their leaves */
+		void finish() {
+			addLeaves(0, 0, 0);
+
+			for (int i = 0; i < 3; i++)
+				last[i] = -1;
+
+			for (uint i = 0; i < leaves.size(); i++) {
+				slots.push_back(leaves[i].value);
+				for (int j = 0; j < 3; j++) {
+					if (markers[j] == leaves[i].value) {
+						last[j] = i;
+						slots[i] = 0;
+					}
+				}
+			}
+
+			for (int i = 0; i < 3; i++) {
+				if (last[i] == -1) {
+					last[i] = slots.size();
+					slots.push_back(0);
+				}
+			}
+		}
+
+		void addLeaves(int node, uint32 code, int length) {
+			if (nodes[node].child[0] == -1) {
+				Leaf leaf;
+				leaf.code = code;
+				leaf.length = length;
+				leaf.value = nodes[node].value;
+				leaves.push_back(leaf);
+				return;
+			}
+
+			addLeaves(nodes[node].child[0], code, length + 1);
+			addLeaves(nodes[node].child[1], code | (1 << length), length + 1);
+		}
+
+		uint32 decode(uint leaf) {
+			uint32 v = slots[leaf];
+			if (v != slots[last[0]]) {
+				slots[last[2]] = slots[last[1]];
+				slots[last[1]] = slots[last[0]];
+				slots[last[0]] = v;
+			}
+			return v;
+		}
+
+		void reset() {
+			slots[last[0]] = slots[last[1]] = slots[last[2]] = 0;
+		}
+	};
+
+	static int addNode(Tree &tree, uint32 value) {
+		Node node;
+		node.child[0] = node.child[1] = -1;
+		node.value = value;
+		tree.nodes.push_back(node);
+		return tree.nodes.size() - 1;
+	}
+
+	/** Add a subtree with all leaves at the given depth, numbered from value on */
+	static int addCompleteTree(Tree &tree, int depth, uint32 &value) {
+		int node = addNode(tree, 0);
+		if (depth == 0) {
+			tree.nodes[node].value = value++;
+		} else {
+			int left = addCompleteTree(tree, depth - 1, value);
+			int right = addCompleteTree(tree, depth - 1, value);
+			tree.nodes[node].child[0] = left;
+			tree.nodes[node].child[1] = right;
+		}
+		return node;
+	}
+
+	/** Add a random subtree, with leaf values which often repeat or match a marker */
+	static int addRandomTree(Tree &tree, Random &random, int depth, int leafPercent, int maxDepth) {
+		bool leaf = depth != 0 && (depth == maxDepth || tree.nodes.size() > 2000 || (int)random.next(100) < leafPercent);
+
+		uint32 value = 0;
+		if (leaf) {
+			switch (random.next(4)) {
+			case 0:
+				value = tree.markers[random.next(3)];
+				break;
+			case 1:
+				value = random.next(16);
+				break;
+			default:
+				value = random.next(0x10000);
+			}
+		}
+
+		int node = addNode(tree, value);
+		if (!leaf) {
+			int left = addRandomTree(tree, random, depth + 1, leafPercent, maxDepth);
+			int right = addRandomTree(tree, random, depth + 1, leafPercent, maxDepth);
+			tree.nodes[node].child[0] = left;
+			tree.nodes[node].child[1] = right;
+		}
+		return node;
+	}
+
+	/** The byte trees are complete, so every byte is coded as its 8 bits, highest first */
+	static void writeByteTree(BitWriter &bw, int depth, uint32 value) {
+		if (depth == 8) {
+			bw.putBit(0);
+			bw.putBits(value, 8);
+			return;
+		}
+
+		bw.putBit(1);
+		writeByteTree(bw, depth + 1, value << 1);
+		writeByteTree(bw, depth + 1, (value << 1) | 1);
+	}
+
+	static void writeByte(BitWriter &bw, uint32 value) {
+		for (int i = 7; i >= 0; i--)
+			bw.putBit((value >> i) & 1);
+	}
+
+	static void writeNode(BitWriter &bw, const Tree &tree, int node) {
+		if (tree.nodes[node].child[0] == -1) {
+			bw.putBit(0);
+			writeByte(bw, tree.nodes[node].value & 0xFF);
+			writeByte(bw, tree.nodes[node].value >> 8);
+			return;
+		}
+
+		bw.putBit(1);
+		writeNode(bw, tree, tree.nodes[node].child[0]);
+		writeNode(bw, tree, tree.nodes[node].child[1]);
+	}
+
+	/**
+	 * Write the tree followed by random codes, decode them with
+	 * BigHuffmanTree and compare the values to the plain decoder.
+	 */
+	template<class BitStream>
+	static bool checkTree(Tree tree, uint32 seed) {
+		tree.finish();
+
+		Random random(seed);
+		BitWriter bw;
+
+		bw.putBit(1);
+		for (int i = 0; i < 2; i++) {
+			bw.putBit(1);
+			writeByteTree(bw, 0, 0);
+			bw.putBit(0);
+		}
+		for (int i = 0; i < 3; i++)
+			bw.putBits(tree.markers[i], 16);
+		writeNode(bw, tree, 0);
+		bw.putBit(0);
+
+		// Prefer the escape leaves, as they change with every code
+		Common::Array<uint> codes;
+		for (int i = 0; i < 4000; i++) {
+			uint leaf = random.next(tree.leaves.size());
+			if (random.next(2) && tree.last[i % 3] < (int)tree.leaves.size())
+				leaf = tree.last[i % 3];
+			codes.push_back(leaf);
+			bw.putBits(tree.leaves[leaf].code, tree.leaves[leaf].length);
+		}
+
+		// Padding, as the decoder reads full prefixes
+		bw.putBits(0, 32);
+
+		const Common::Array<byte> &data = bw.getData();
+		Common::MemoryReadStream stream(&data[0], data.size());
+		BitStream bs(stream);
+
+		Video::BigHuffmanTree bigTree(bs, (tree.nodes.size() + 3) * 4);
+
+		for (uint i = 0; i < codes.size(); i++) {
+			// Like at the start of a frame
+			if (random.next(500) == 0) {
+				bigTree.reset();
+				tree.reset();
+			}
+
+			if (bigTree.getCode(bs) != tree.decode(codes[i]))
+				return false;
+		}
+
+		return true;
+	}
+
+	static void checkAllStreams(const Tree &tree, uint32 seed) {
+		TS_ASSERT(checkTree<Common::BitStream8LSB>(tree, seed));
+#ifdef HAVE_INT64
+		TS_ASSERT(checkTree<Common::BitStreamCached8LSB>(tree, seed));
+#endif
+	}
+
+public:
+	void test_empty_tree() {
+		const byte data[4] = { 0x00, 0xFF, 0xFF, 0xFF };
+		Common::MemoryReadStream stream(data, sizeof(data));
+		Common::BitStream8LSB bs(stream);
+
+		Video::BigHuffmanTree tree(bs, 0);
+		TS_ASSERT_EQUALS(tree.getCode(bs), (uint32)0);
+		TS_ASSERT_EQUALS(tree.getCode(bs), (uint32)0);
+		TS_ASSERT_EQUALS(bs.pos(), (uint32)1);
+	}
+
+	void test_prefix_length_leaves() {
+		// All codes are exactly as long as the prefix table
+		Tree tree;
+		uint32 value = 0;
+		tree.markers[0] = 7;
+		tree.markers[1] = 4095;
+		tree.markers[2] = 0x1234;
+		addCompleteTree(tree, 12, value);
+		checkAllStreams(tree, 1);
+	}
+
+	void test_prefix_length_nodes() {
+		// All internal nodes at the depth of the prefix table
+		Tree tree;
+		uint32 value = 0;
+		tree.markers[0] = 0;
+		tree.markers[1] = 8191;
+		tree.markers[2] = 4096;
+		addCompleteTree(tree, 13, value);
+		checkAllStreams(tree, 2);
+	}
+
+	void test_escape_leaves() {
+		// A leaf at every depth, with the escape leaves shorter than the
+		// prefix table, as long and longer
+		Tree tree;
+		tree.markers[0] = 3;
+		tree.markers[1] = 12;
+		tree.markers[2] = 17;
+
+		int node = addNode(tree, 0);
+		for (int depth = 1; depth <= 20; depth++) {
+			int leaf = addNode(tree, depth);
+			int next = addNode(tree, 100 + depth);
+			tree.nodes[node].child[0] = leaf;
+			tree.nodes[node].child[1] = next;
+			node = next;
+		}
+		checkAllStreams(tree, 3);
+	}
+
+	void test_random_trees() {
+		Random random(4);
+
+		for (int i = 0; i < 200; i++) {
+			Tree tree;
+
+			// Markers which may match each other as well as leaves
+			for (int j = 0; j < 3; j++)
+				tree.markers[j] = (j != 0 && random.next(4) == 0) ? tree.markers[j - 1] : random.next(32);
+
+			addRandomTree(tree, random, 0, 10 + random.next(40), 8 + random.next(16));
+			checkAllStreams(tree, i);
+		}
+	}
+};
@@ -47,6 +47,11 @@
 #include "video/binkdata.h"
 #include "video/bink_decoder.h"
 
+#if defined(__SSE2__)
+#define USE_SSE2_IDCT
+#include <emmintrin.h>
+#endif
+
 static const uint32 kBIKfID = MKTAG('B', 'I', 'K', 'f');
 static const uint32 kBIKgID = MKTAG('B', 'I', 'K', 'g');
 static const uint32 kBIKhID = MKTAG('B', 'I', 'K', 'h');
@@ -57,11 +62,36 @@ static const uint32 kVideoFlagAlpha = 0x00100000;
 static const uint16 kAudioFlagDCT    = 0x1000;
 static const uint16 kAudioFlagStereo = 0x2000;
 
+// The packets are read exclusively through the bit stream, so it can read ahead
+#ifdef HAVE_INT64
+typedef Common::BitStreamCached32LELSB BinkBitStream;
+#else
+typedef Common::BitStream32LELSB BinkBitStream;
+#endif
+
 // Number of bits used to store first DC value in bundle
 static const uint32 kDCStartBits = 11;
 
 namespace Video {
 
+#ifdef USE_SSE2_IDCT
+
+/** Add the low 8 bits of eight rows of 16-bit values to a block of pixels, wrapping around */
+static inline void addRowsSSE2(byte *dest, uint32 pitch, const __m128i *rows) {
+	const __m128i mask = _mm_set1_epi16(0xFF);
+
+	for (int i = 0; i < 8; i += 2, dest += 2 * pitch) {
+		const __m128i add = _mm_packus_epi16(_mm_and_si128(rows[i], mask), _mm_and_si128(rows[i + 1], mask));
+		const __m128i pixels = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)dest), _mm_loadl_epi64((const __m128i *)(dest + pitch)));
+		const __m128i sum = _mm_add_epi8(pixels, add);
+
+		_mm_storel_epi64((__m128i *)dest, sum);
+		_mm_storel_epi64((__m128i *)(dest + pitch), _mm_srli_si128(sum, 8));
+	}
+}
+
+#endif
+
 BinkDecoder::BinkDecoder() {
 	_bink = 0;
 }
@@ -187,7 +217,7 @@ void BinkDecoder::readNextPacket() {
 			//                  Number of samples in bytes
 			audio.sampleCount = _bink->readUint32LE() / (2 * audio.channels);
 
-			audio.bits = new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
+			audio.bits = new BinkBitStream(new Common::SeekableSubReadStream(_bink,
 					audioPacketStart + 4, audioPacketEnd), true);
 
 			audioTrack->decodePacket();
@@ -204,7 +234,7 @@ void BinkDecoder::readNextPacket() {
 	uint32 videoPacketStart = _bink->pos();
 	uint32 videoPacketEnd   = _bink->pos() + frameSize;
 
-	frame.bits = new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
+	frame.bits = new BinkBitStream(new Common::SeekableSubReadStream(_bink,
 			videoPacketStart, videoPacketEnd), true);
 
 	videoTrack->decodePacket(frame);
@@ -806,11 +836,19 @@ void BinkDecoder::BinkVideoTrack::blockResidue(DecodeContext &ctx) {
 
 	readResidue(*ctx.video, block, v);
 
+#ifdef USE_SSE2_IDCT
+	__m128i rows[8];
+	for (int i = 0; i < 8; i++)
+		rows[i] = _mm_loadu_si128((const __m128i *)(block + 8 * i));
+
+	addRowsSSE2(ctx.dest, ctx.pitch, rows);
+#else
 	byte  *dst = ctx.dest;
 	int16 *src = block;
 	for (int i = 0; i < 8; i++, dst += ctx.pitch, src += 8)
 		for (int j = 0; j < 8; j++)
 			dst[j] += src[j];
+#endif
 }
 
 void BinkDecoder::BinkVideoTrack::blockIntra(DecodeContext &ctx) {
@@ -1311,7 +1349,156 @@ static inline void IDCTCol(int16 *dest, const int16 *src) {
 	}
 }
 
+#ifdef USE_SSE2_IDCT
+
+/*
+ * The SSE2 IDCT works on four columns (or rows) at a time in 32-bit lanes,
+ * so it is bit-exact with IDCT_TRANSFORM, including the truncation of the
+ * intermediate results to 16 bits. The column shortcut of IDCTCol() gives
+ * the same result as the full transform, so it is not needed here.
+ */
+
+/** Multiply the 32-bit lanes of x by those of c, keeping the low 32 bits of the products */
+static inline __m128i mulLo32(__m128i x, __m128i c) {
+	const __m128i even = _mm_mul_epu32(x, c);
+	const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(c, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/** IDCT_TRANSFORM, on four sets of values at once */
+static inline void idctTransformSSE2(const __m128i *s, __m128i *d) {
+	const __m128i a0 = _mm_add_epi32(s[0], s[4]);
+	const __m128i a1 = _mm_sub_epi32(s[0], s[4]);
+	const __m128i a2 = _mm_add_epi32(s[2], s[6]);
+	const __m128i a3 = _mm_srai_epi32(mulLo32(_mm_sub_epi32(s[2], s[6]), _mm_set1_epi32(A1)), 11);
+	const __m128i a4 = _mm_add_epi32(s[5], s[3]);
+	const __m128i a5 = _mm_sub_epi32(s[5], s[3]);
+	const __m128i a6 = _mm_add_epi32(s[1], s[7]);
+	const __m128i a7 = _mm_sub_epi32(s[1], s[7]);
+	const __m128i b0 = _mm_add_epi32(a4, a6);
+	const __m128i b1 = _mm_srai_epi32(mulLo32(_mm_add_epi32(a5, a7), _mm_set1_epi32(A3)), 11);
+	const __m128i b2 = _mm_add_epi32(_mm_sub_epi32(_mm_srai_epi32(mulLo32(a5, _mm_set1_epi32(A4)), 11), b0), b1);
+	const __m128i b3 = _mm_sub_epi32(_mm_srai_epi32(mulLo32(_mm_sub_epi32(a6, a4), _mm_set1_epi32(A1)), 11), b2);
+	const __m128i b4 = _mm_sub_epi32(_mm_add_epi32(_mm_srai_epi32(mulLo32(a7, _mm_set1_epi32(A2)), 11), b3), b1);
+
+	const __m128i a0a2 = _mm_add_epi32(a0, a2);
+	const __m128i a0s2 = _mm_sub_epi32(a0, a2);
+	const __m128i a1a3 = _mm_sub_epi32(_mm_add_epi32(a1, a3), a2);
+	const __m128i a1s3 = _mm_add_epi32(_mm_sub_epi32(a1, a3), a2);
+
+	d[0] = _mm_add_epi32(a0a2, b0);
+	d[1] = _mm_add_epi32(a1a3, b2);
+	d[2] = _mm_add_epi32(a1s3, b3);
+	d[3] = _mm_sub_epi32(a0s2, b4);
+	d[4] = _mm_add_epi32(a0s2, b4);
+	d[5] = _mm_sub_epi32(a1s3, b3);
+	d[6] = _mm_sub_epi32(a1a3, b2);
+	d[7] = _mm_sub_epi32(a0a2, b0);
+}
+
+/** Truncate two sets of four 32-bit values to 16 bits, and pack them together */
+static inline __m128i packTruncate(__m128i lo, __m128i hi) {
+	return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16), _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+}
+
+/** Transpose an 8x8 matrix of 16-bit values, one row per register */
+static inline void transpose8x8(__m128i *r) {
+	const __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+	const __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+	const __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+	const __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+	const __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+	const __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+	const __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+	const __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+	const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	r[0] = _mm_unpacklo_epi64(b0, b4);
+	r[1] = _mm_unpackhi_epi64(b0, b4);
+	r[2] = _mm_unpacklo_epi64(b1, b5);
+	r[3] = _mm_unpackhi_epi64(b1, b5);
+	r[4] = _mm_unpacklo_epi64(b2, b6);
+	r[5] = _mm_unpackhi_epi64(b2, b6);
+	r[6] = _mm_unpacklo_epi64(b3, b7);
+	r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/**
+ * Run one pass of the IDCT over the columns of an 8x8 matrix of 16-bit
+ * values, one row per register. The results are truncated to 16 bits, after
+ * applying MUNGE_ROW if munge is set.
+ */
+static inline void idctPassSSE2(__m128i *r, bool munge) {
+	__m128i s[8], lo[8], hi[8];
+
+	for (int i = 0; i < 8; i++)
+		s[i] = _mm_srai_epi32(_mm_unpacklo_epi16(r[i], r[i]), 16);
+	idctTransformSSE2(s, lo);
+
+	for (int i = 0; i < 8; i++)
+		s[i] = _mm_srai_epi32(_mm_unpackhi_epi16(r[i], r[i]), 16);
+	idctTransformSSE2(s, hi);
+
+	for (int i = 0; i < 8; i++) {
+		if (munge) {
+			lo[i] = _mm_srai_epi32(_mm_add_epi32(lo[i], _mm_set1_epi32(0x7F)), 8);
+			hi[i] = _mm_srai_epi32(_mm_add_epi32(hi[i], _mm_set1_epi32(0x7F)), 8);
+		}
+
+		r[i] = packTruncate(lo[i], hi[i]);
+	}
+}
+
+/**
+ * The full IDCT of a block, returning its rows truncated to 16 bits. Only
+ * their low 8 bits matter when they are written to a plane.
+ */
+static inline void idctSSE2(const int16 *block, __m128i *rows) {
+	__m128i acRows = _mm_setzero_si128();
+	for (int i = 0; i < 8; i++) {
+		rows[i] = _mm_loadu_si128((const __m128i *)(block + 8 * i));
+		if (i > 0)
+			acRows = _mm_or_si128(acRows, rows[i]);
+	}
+
+	if (_mm_movemask_epi8(_mm_cmpeq_epi16(acRows, _mm_setzero_si128())) == 0xFFFF) {
+		// Only the first row is set, as in DC only blocks: the column pass
+		// copies it into every row, so all rows come out the same
+		int16 row[8];
+		IDCT_ROW(row, block);
+
+		rows[0] = _mm_loadu_si128((const __m128i *)row);
+		for (int i = 1; i < 8; i++)
+			rows[i] = rows[0];
+		return;
+	}
+
+	idctPassSSE2(rows, false);
+
+	// The row pass runs over the columns of the transposed matrix
+	transpose8x8(rows);
+	idctPassSSE2(rows, true);
+	transpose8x8(rows);
+}
+
+#endif // USE_SSE2_IDCT
+
 void BinkDecoder::BinkVideoTrack::IDCT(int16 *block) {
+#ifdef USE_SSE2_IDCT
+	__m128i rows[8];
+	idctSSE2(block, rows);
+
+	for (int i = 0; i < 8; i++)
+		_mm_storeu_si128((__m128i *)(block + 8 * i), rows[i]);
+#else
 	int i;
 	int16 temp[64];
 
@@ -1320,9 +1507,15 @@ void BinkDecoder::BinkVideoTrack::IDCT(int16 *block) {
 	for (i = 0; i < 8; i++) {
 		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
 	}
+#endif
 }
 
 void BinkDecoder::BinkVideoTrack::IDCTAdd(DecodeContext &ctx, int16 *block) {
+#ifdef USE_SSE2_IDCT
+	__m128i rows[8];
+	idctSSE2(block, rows);
+	addRowsSSE2(ctx.dest, ctx.pitch, rows);
+#else
 	int i, j;
 
 	IDCT(block);
@@ -1330,9 +1523,23 @@ void BinkDecoder::BinkVideoTrack::IDCTAdd(DecodeContext &ctx, int16 *block) {
 	for (i = 0; i < 8; i++, dest += ctx.pitch, block += 8)
 		for (j = 0; j < 8; j++)
 			 dest[j] += block[j];
+#endif
 }
 
 void BinkDecoder::BinkVideoTrack::IDCTPut(DecodeContext &ctx, int16 *block) {
+#ifdef USE_SSE2_IDCT
+	const __m128i mask = _mm_set1_epi16(0xFF);
+	__m128i rows[8];
+	idctSSE2(block, rows);
+
+	byte *dest = ctx.dest;
+	for (int i = 0; i < 8; i += 2, dest += 2 * ctx.pitch) {
+		const __m128i pixels = _mm_packus_epi16(_mm_and_si128(rows[i], mask), _mm_and_si128(rows[i + 1], mask));
+
+		_mm_storel_epi64((__m128i *)dest, pixels);
+		_mm_storel_epi64((__m128i *)(dest + ctx.pitch), _mm_srli_si128(pixels, 8));
+	}
+#else
 	int i;
 	int16 temp[64];
 	for (i = 0; i < 8; i++)
@@ -1340,6 +1547,7 @@ void BinkDecoder::BinkVideoTrack::IDCTPut(DecodeContext &ctx, int16 *block) {
 	for (i = 0; i < 8; i++) {
 		IDCT_ROW( (&ctx.dest[i*ctx.pitch]), (&temp[8*i]) );
 	}
+#endif
 }
 
 BinkDecoder::BinkAudioTrack::BinkAudioTrack(BinkDecoder::AudioInfo &audio) : _audioInfo(&audio) {
@@ -10,6 +10,7 @@ MODULE_OBJS := \
 	psx_decoder.o \
 	qt_decoder.o \
 	smk_decoder.o \
+	smk_huffman.o \
 	video_decoder.o
 
 ifdef USE_THEORADEC
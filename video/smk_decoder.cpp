@@ -27,6 +27,7 @@
 // http://git.ffmpeg.org/?p=ffmpeg;a=blob;f=libavcodec/smacker.c;hb=b8437a00a2f14d4a437346455d624241d726128e
 
 #include "video/smk_decoder.h"
+#include "video/smk_huffman.h"
 
 #include "common/endian.h"
 #include "common/util.h"
@@ -42,6 +43,13 @@
 
 namespace Video {
 
+// The trees and packets are read exclusively through the bit stream, so it can read ahead
+#ifdef HAVE_INT64
+typedef Common::BitStreamCached8LSB SmackerBitStream;
+#else
+typedef Common::BitStream8LSB SmackerBitStream;
+#endif
+
 enum SmkBlockTypes {
 	SMK_BLOCK_MONO = 0,
 	SMK_BLOCK_FULL = 1,
@@ -49,236 +57,6 @@ enum SmkBlockTypes {
 	SMK_BLOCK_FILL = 3
 };
 
-/*
- * class SmallHuffmanTree
- * A Huffman-tree to hold 8-bit values.
- */
-
-class SmallHuffmanTree {
-public:
-	SmallHuffmanTree(Common::BitStream &bs);
-
-	uint16 getCode(Common::BitStream &bs);
-private:
-	enum {
-		SMK_NODE = 0x8000
-	};
-
-	uint16 decodeTree(uint32 prefix, int length);
-
-	uint16 _treeSize;
-	uint16 _tree[511];
-
-	uint16 _prefixtree[256];
-	byte _prefixlength[256];
-
-	Common::BitStream &_bs;
-};
-
-SmallHuffmanTree::SmallHuffmanTree(Common::BitStream &bs)
-	: _treeSize(0), _bs(bs) {
-	uint32 bit = _bs.getBit();
-	assert(bit);
-
-	for (uint16 i = 0; i < 256; ++i)
-		_prefixtree[i] = _prefixlength[i] = 0;
-
-	decodeTree(0, 0);
-
-	bit = _bs.getBit();
-	assert(!bit);
-}
-
-uint16 SmallHuffmanTree::decodeTree(uint32 prefix, int length) {
-	if (!_bs.getBit()) { // Leaf
-		_tree[_treeSize] = _bs.getBits(8);
-
-		if (length <= 8) {
-			for (int i = 0; i < 256; i += (1 << length)) {
-				_prefixtree[prefix | i] = _treeSize;
-				_prefixlength[prefix | i] = length;
-			}
-		}
-		++_treeSize;
-
-		return 1;
-	}
-
-	uint16 t = _treeSize++;
-
-	if (length == 8) {
-		_prefixtree[prefix] = t;
-		_prefixlength[prefix] = 8;
-	}
-
-	uint16 r1 = decodeTree(prefix, length + 1);
-
-	_tree[t] = (SMK_NODE | r1);
-
-	uint16 r2 = decodeTree(prefix | (1 << length), length + 1);
-
-	return r1+r2+1;
-}
-
-uint16 SmallHuffmanTree::getCode(Common::BitStream &bs) {
-	byte peek = bs.peekBits(MIN<uint32>(bs.size() - bs.pos(), 8));
-	uint16 *p = &_tree[_prefixtree[peek]];
-	bs.skip(_prefixlength[peek]);
-
-	while (*p & SMK_NODE) {
-		if (bs.getBit())
-			p += *p & ~SMK_NODE;
-		p++;
-	}
-
-	return *p;
-}
-
-/*
- * class BigHuffmanTree
- * A Huffman-tree to hold 16-bit values.
- */
-
-class BigHuffmanTree {
-public:
-	BigHuffmanTree(Common::BitStream &bs, int allocSize);
-	~BigHuffmanTree();
-
-	void reset();
-	uint32 getCode(Common::BitStream &bs);
-private:
-	enum {
-		SMK_NODE = 0x80000000
-	};
-
-	uint32 decodeTree(uint32 prefix, int length);
-
-	uint32  _treeSize;
-	uint32 *_tree;
-	uint32  _last[3];
-
-	uint32 _prefixtree[256];
-	byte _prefixlength[256];
-
-	/* Used during construction */
-	Common::BitStream &_bs;
-	uint32 _markers[3];
-	SmallHuffmanTree *_loBytes;
-	SmallHuffmanTree *_hiBytes;
-};
-
-BigHuffmanTree::BigHuffmanTree(Common::BitStream &bs, int allocSize)
-	: _bs(bs) {
-	uint32 bit = _bs.getBit();
-	if (!bit) {
-		_tree = new uint32[1];
-		_tree[0] = 0;
-		_last[0] = _last[1] = _last[2] = 0;
-		return;
-	}
-
-	for (uint32 i = 0; i < 256; ++i)
-		_prefixtree[i] = _prefixlength[i] = 0;
-
-	_loBytes = new SmallHuffmanTree(_bs);
-	_hiBytes = new SmallHuffmanTree(_bs);
-
-	_markers[0] = _bs.getBits(16);
-	_markers[1] = _bs.getBits(16);
-	_markers[2] = _bs.getBits(16);
-
-	_last[0] = _last[1] = _last[2] = 0xffffffff;
-
-	_treeSize = 0;
-	_tree = new uint32[allocSize / 4];
-	decodeTree(0, 0);
-	bit = _bs.getBit();
-	assert(!bit);
-
-	for (uint32 i = 0; i < 3; ++i) {
-		if (_last[i] == 0xffffffff) {
-			_last[i] = _treeSize;
-			_tree[_treeSize++] = 0;
-		}
-	}
-
-	delete _loBytes;
-	delete _hiBytes;
-}
-
-BigHuffmanTree::~BigHuffmanTree() {
-	delete[] _tree;
-}
-
-void BigHuffmanTree::reset() {
-	_tree[_last[0]] = _tree[_last[1]] = _tree[_last[2]] = 0;
-}
-
-uint32 BigHuffmanTree::decodeTree(uint32 prefix, int length) {
-	uint32 bit = _bs.getBit();
-
-	if (!bit) { // Leaf
-		uint32 lo = _loBytes->getCode(_bs);
-		uint32 hi = _hiBytes->getCode(_bs);
-
-		uint32 v = (hi << 8) | lo;
-
-		_tree[_treeSize] = v;
-
-		if (length <= 8) {
-			for (int i = 0; i < 256; i += (1 << length)) {
-				_prefixtree[prefix | i] = _treeSize;
-				_prefixlength[prefix | i] = length;
-			}
-		}
-
-		for (int i = 0; i < 3; ++i) {
-			if (_markers[i] == v) {
-				_last[i] = _treeSize;
-				_tree[_treeSize] = 0;
-			}
-		}
-		++_treeSize;
-
-		return 1;
-	}
-
-	uint32 t = _treeSize++;
-
-	if (length == 8) {
-		_prefixtree[prefix] = t;
-		_prefixlength[prefix] = 8;
-	}
-
-	uint32 r1 = decodeTree(prefix, length + 1);
-
-	_tree[t] = SMK_NODE | r1;
-
-	uint32 r2 = decodeTree(prefix | (1 << length), length + 1);
-	return r1+r2+1;
-}
-
-uint32 BigHuffmanTree::getCode(Common::BitStream &bs) {
-	byte peek = bs.peekBits(MIN<uint32>(bs.size() - bs.pos(), 8));
-	uint32 *p = &_tree[_prefixtree[peek]];
-	bs.skip(_prefixlength[peek]);
-
-	while (*p & SMK_NODE) {
-		if (bs.getBit())
-			p += (*p) & ~SMK_NODE;
-		p++;
-	}
-
-	uint32 v = *p;
-	if (v != _tree[_last[0]]) {
-		_tree[_last[2]] = _tree[_last[1]];
-		_tree[_last[1]] = _tree[_last[0]];
-		_tree[_last[0]] = v;
-	}
-
-	return v;
-}
-
 SmackerDecoder::SmackerDecoder(Audio::Mixer::SoundType soundType) : _soundType(soundType) {
 	_fileStream = 0;
 	_firstFrameStart = 0;
@@ -388,7 +166,7 @@ bool SmackerDecoder::loadStream(Common::SeekableReadStream *stream) {
 	byte *huffmanTrees = (byte *) malloc(_header.treesSize);
 	_fileStream->read(huffmanTrees, _header.treesSize);
 
-	Common::BitStream8LSB bs(new Common::MemoryReadStream(huffmanTrees, _header.treesSize, DisposeAfterUse::YES), true);
+	SmackerBitStream bs(new Common::MemoryReadStream(huffmanTrees, _header.treesSize, DisposeAfterUse::YES), true);
 	videoTrack->readTrees(bs, _header.mMapSize, _header.mClrSize, _header.fullSize, _header.typeSize);
 
 	_firstFrameStart = _fileStream->pos();
@@ -471,7 +249,7 @@ void SmackerDecoder::readNextPacket() {
 
 	_fileStream->read(frameData, frameDataSize);
 
-	Common::BitStream8LSB bs(new Common::MemoryReadStream(frameData, frameDataSize + 1, DisposeAfterUse::YES), true);
+	SmackerBitStream bs(new Common::MemoryReadStream(frameData, frameDataSize + 1, DisposeAfterUse::YES), true);
 	videoTrack->decodeFrame(bs);
 
 	_fileStream->seek(startPos + frameSize);
@@ -681,20 +459,20 @@ void SmackerDecoder::SmackerVideoTrack::decodeFrame(Common::BitStream &bs) {
 			}
 			break;
 		case SMK_BLOCK_SKIP:
-			while (run-- && block < blocks)
-				block++;
+			block += MIN(run, blocks - block);
 			break;
 		case SMK_BLOCK_FILL:
-			uint32 col;
+			// Fill the blocks of the run which are on the same row at once
 			mode = type >> 8;
-			while (run-- && block < blocks) {
+			while (run && block < blocks) {
+				uint count = MIN(run, bw - block % bw);
 				out = (byte *)_surface->getPixels() + (block / bw) * (stride * 4 * doubleY) + (block % bw) * 4;
-				col = mode * 0x01010101;
 				for (i = 0; i < 4 * doubleY; ++i) {
-					out[0] = out[1] = out[2] = out[3] = col;
+					memset(out, mode, count * 4);
 					out += stride;
 				}
-				++block;
+				block += count;
+				run -= count;
 			}
 			break;
 		}
@@ -773,7 +551,7 @@ Audio::AudioStream *SmackerDecoder::SmackerAudioTrack::getAudioStream() const {
 }
 
 void SmackerDecoder::SmackerAudioTrack::queueCompressedBuffer(byte *buffer, uint32 bufferSize, uint32 unpackedSize) {
-	Common::BitStream8LSB audioBS(new Common::MemoryReadStream(buffer, bufferSize), true);
+	SmackerBitStream audioBS(new Common::MemoryReadStream(buffer, bufferSize), true);
 	bool dataPresent = audioBS.getBit();
 
 	if (!dataPresent)
@@ -0,0 +1,204 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Based on the ScummVM (GPLv2+) Smacker decoder (originally in video/smk_decoder.cpp)
+
+#include "video/smk_huffman.h"
+
+#include "common/bitstream.h"
+#include "common/util.h"
+
+namespace Video {
+
+SmallHuffmanTree::SmallHuffmanTree(Common::BitStream &bs)
+	: _treeSize(0), _bs(bs) {
+	uint32 bit = _bs.getBit();
+	assert(bit);
+
+	for (uint16 i = 0; i < 256; ++i)
+		_prefixtree[i] = _prefixlength[i] = 0;
+
+	decodeTree(0, 0);
+
+	bit = _bs.getBit();
+	assert(!bit);
+}
+
+uint16 SmallHuffmanTree::decodeTree(uint32 prefix, int length) {
+	if (!_bs.getBit()) { // Leaf
+		_tree[_treeSize] = _bs.getBits(8);
+
+		if (length <= 8) {
+			for (int i = 0; i < 256; i += (1 << length)) {
+				_prefixtree[prefix | i] = _treeSize;
+				_prefixlength[prefix | i] = length;
+			}
+		}
+		++_treeSize;
+
+		return 1;
+	}
+
+	uint16 t = _treeSize++;
+
+	if (length == 8) {
+		_prefixtree[prefix] = t;
+		_prefixlength[prefix] = 8;
+	}
+
+	uint16 r1 = decodeTree(prefix, length + 1);
+
+	_tree[t] = (SMK_NODE | r1);
+
+	uint16 r2 = decodeTree(prefix | (1 << length), length + 1);
+
+	return r1+r2+1;
+}
+
+uint16 SmallHuffmanTree::getCode(Common::BitStream &bs) {
+	byte peek = bs.peekBits(MIN<uint32>(bs.size() - bs.pos(), 8));
+	uint16 *p = &_tree[_prefixtree[peek]];
+	bs.skip(_prefixlength[peek]);
+
+	while (*p & SMK_NODE) {
+		if (bs.getBit())
+			p += *p & ~SMK_NODE;
+		p++;
+	}
+
+	return *p;
+}
+
+BigHuffmanTree::BigHuffmanTree(Common::BitStream &bs, int allocSize)
+	: _bs(bs) {
+	// An empty tree hands out 0 without reading any bits
+	for (uint32 i = 0; i < (1 << kPrefixBits); ++i)
+		_prefixtree[i] = _prefixlength[i] = 0;
+
+	uint32 bit = _bs.getBit();
+	if (!bit) {
+		_tree = new uint32[1];
+		_tree[0] = 0;
+		_last[0] = _last[1] = _last[2] = 0;
+		return;
+	}
+
+	_loBytes = new SmallHuffmanTree(_bs);
+	_hiBytes = new SmallHuffmanTree(_bs);
+
+	_markers[0] = _bs.getBits(16);
+	_markers[1] = _bs.getBits(16);
+	_markers[2] = _bs.getBits(16);
+
+	_last[0] = _last[1] = _last[2] = 0xffffffff;
+
+	_treeSize = 0;
+	_tree = new uint32[allocSize / 4];
+	decodeTree(0, 0);
+	bit = _bs.getBit();
+	assert(!bit);
+
+	for (uint32 i = 0; i < 3; ++i) {
+		if (_last[i] == 0xffffffff) {
+			_last[i] = _treeSize;
+			_tree[_treeSize++] = 0;
+		}
+	}
+
+	delete _loBytes;
+	delete _hiBytes;
+}
+
+BigHuffmanTree::~BigHuffmanTree() {
+	delete[] _tree;
+}
+
+void BigHuffmanTree::reset() {
+	_tree[_last[0]] = _tree[_last[1]] = _tree[_last[2]] = 0;
+}
+
+uint32 BigHuffmanTree::decodeTree(uint32 prefix, int length) {
+	uint32 bit = _bs.getBit();
+
+	if (!bit) { // Leaf
+		uint32 lo = _loBytes->getCode(_bs);
+		uint32 hi = _hiBytes->getCode(_bs);
+
+		uint32 v = (hi << 8) | lo;
+
+		_tree[_treeSize] = v;
+
+		if (length <= kPrefixBits) {
+			for (int i = 0; i < (1 << kPrefixBits); i += (1 << length)) {
+				_prefixtree[prefix | i] = _treeSize;
+				_prefixlength[prefix | i] = length;
+			}
+		}
+
+		for (int i = 0; i < 3; ++i) {
+			if (_markers[i] == v) {
+				_last[i] = _treeSize;
+				_tree[_treeSize] = 0;
+			}
+		}
+		++_treeSize;
+
+		return 1;
+	}
+
+	uint32 t = _treeSize++;
+
+	if (length == kPrefixBits) {
+		_prefixtree[prefix] = t;
+		_prefixlength[prefix] = kPrefixBits;
+	}
+
+	uint32 r1 = decodeTree(prefix, length + 1);
+
+	_tree[t] = SMK_NODE | r1;
+
+	uint32 r2 = decodeTree(prefix | (1 << length), length + 1);
+	return r1+r2+1;
+}
+
+uint32 BigHuffmanTree::getCode(Common::BitStream &bs) {
+	uint32 peek = bs.peekBits(MIN<uint32>(bs.size() - bs.pos(), kPrefixBits));
+	uint32 *p = &_tree[_prefixtree[peek]];
+	bs.skip(_prefixlength[peek]);
+
+	while (*p & SMK_NODE) {
+		if (bs.getBit())
+			p += (*p) & ~SMK_NODE;
+		p++;
+	}
+
+	uint32 v = *p;
+	if (v != _tree[_last[0]]) {
+		_tree[_last[2]] = _tree[_last[1]];
+		_tree[_last[1]] = _tree[_last[0]];
+		_tree[_last[0]] = v;
+	}
+
+	return v;
+}
+
+} // End of namespace Video
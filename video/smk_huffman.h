@@ -0,0 +1,106 @@
+/* Cabal - Legacy Game Implementations
+ *
+ * Cabal is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Based on the ScummVM (GPLv2+) Smacker decoder (originally in video/smk_decoder.cpp)
+
+#ifndef VIDEO_SMK_HUFFMAN_H
+#define VIDEO_SMK_HUFFMAN_H
+
+#include "common/scummsys.h"
+
+namespace Common {
+class BitStream;
+}
+
+namespace Video {
+
+/*
+ * class SmallHuffmanTree
+ * A Huffman-tree to hold 8-bit values.
+ */
+
+class SmallHuffmanTree {
+public:
+	SmallHuffmanTree(Common::BitStream &bs);
+
+	uint16 getCode(Common::BitStream &bs);
+private:
+	enum {
+		SMK_NODE = 0x8000
+	};
+
+	uint16 decodeTree(uint32 prefix, int length);
+
+	uint16 _treeSize;
+	uint16 _tree[511];
+
+	uint16 _prefixtree[256];
+	byte _prefixlength[256];
+
+	Common::BitStream &_bs;
+};
+
+/*
+ * class BigHuffmanTree
+ * A Huffman-tree to hold 16-bit values.
+ *
+ * Codes of up to kPrefixBits bits are resolved with a single lookup in the
+ * prefix table, only longer ones walk the rest of the tree bit by bit. The
+ * table points to the leaves instead of holding their values, as the three
+ * "escape" leaves hand out the last codes decoded.
+ */
+
+class BigHuffmanTree {
+public:
+	BigHuffmanTree(Common::BitStream &bs, int allocSize);
+	~BigHuffmanTree();
+
+	void reset();
+	uint32 getCode(Common::BitStream &bs);
+private:
+	enum {
+		SMK_NODE = 0x80000000
+	};
+
+	enum {
+		kPrefixBits = 12
+	};
+
+	uint32 decodeTree(uint32 prefix, int length);
+
+	uint32  _treeSize;
+	uint32 *_tree;
+	uint32  _last[3];
+
+	uint32 _prefixtree[1 << kPrefixBits];
+	byte _prefixlength[1 << kPrefixBits];
+
+	/* Used during construction */
+	Common::BitStream &_bs;
+	uint32 _markers[3];
+	SmallHuffmanTree *_loBytes;
+	SmallHuffmanTree *_hiBytes;
+};
+
+} // End of namespace Video
+
+#endif
@@ -29,6 +29,7 @@
 
 #include "common/rational.h"
 #include "common/file.h"
+#include "common/readaheadstream.h"
 #include "common/system.h"
 
 #include "graphics/palette.h"
@@ -50,6 +51,15 @@ VideoDecoder::VideoDecoder() {
 	_nextVideoTrack = 0;
 	_mainAudioTrack = 0;
 	_canSetDither = true;
+	_readAhead = false;
+	_readAheadStream = 0;
+	_decodeAheadHead = 0;
+	_decodeAheadCount = 0;
+	_decodeAheadFrames = 0;
+	_decodeAheadTrack = 0;
+	_decodeAheadCurFrame = -1;
+	_decodeAheadFrameTime = 0;
+	memset(&_decodeAheadStats, 0, sizeof(_decodeAheadStats));
 
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
@@ -62,6 +72,13 @@ void VideoDecoder::close() {
 	if (isPlaying())
 		stop();
 
+	_readAheadStream = 0;
+
+	stopDecodeAhead();
+	_decodeAheadQueue.clear();
+	_decodeAheadFrameTime = 0;
+	memset(&_decodeAheadStats, 0, sizeof(_decodeAheadStats));
+
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		delete *it;
 
@@ -91,7 +108,15 @@ bool VideoDecoder::loadFile(const Common::String &filename) {
 		return false;
 	}
 
-	return loadStream(file);
+	if (!_readAhead)
+		return loadStream(file);
+
+	Common::ReadAheadStream *stream = new Common::ReadAheadStream(file, DisposeAfterUse::YES);
+	if (!loadStream(stream))
+		return false;
+
+	_readAheadStream = stream;
+	return true;
 }
 
 bool VideoDecoder::needsUpdate() const {
@@ -177,6 +202,9 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 	_canSetDither = false;
 
+	if (_decodeAheadFrames != 0 && (_decodeAheadTrack || startDecodeAhead()))
+		return decodeQueuedFrame();
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -202,6 +230,15 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	if (reverse && _decodeAheadTrack) {
+		// Move back to the first frame which was decoded, but not shown yet.
+		// If that fails, keep the queued frames and play on forward.
+		if (_decodeAheadCount != 0 && !seekIntern(_decodeAheadQueue[_decodeAheadHead].startTime))
+			return false;
+
+		stopDecodeAhead();
+	}
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
@@ -216,6 +253,33 @@ bool VideoDecoder::setReverse(bool reverse) {
 	return true;
 }
 
+void VideoDecoder::setDecodeAhead(uint frameCount) {
+	if (_decodeAheadTrack) {
+		warning("Cannot change decoding ahead while frames are decoded ahead");
+		return;
+	}
+
+	_decodeAheadFrames = frameCount;
+}
+
+bool VideoDecoder::decodeAhead() {
+	// Decoding one more frame must not delay the frame which is due next
+	if (_decodeAheadTrack && canDecodeAhead() &&
+			(_decodeAheadCount == 0 || getTimeToNextFrame() > _decodeAheadFrameTime)) {
+		queueNextFrame();
+		_decodeAheadStats.framesDecoded++;
+		return true;
+	}
+
+	return _readAheadStream && _readAheadStream->fillNextBlock();
+}
+
+VideoDecoder::DecodeAheadStats VideoDecoder::getDecodeAheadStats() const {
+	DecodeAheadStats stats = _decodeAheadStats;
+	stats.queueDepth = _decodeAheadCount;
+	return stats;
+}
+
 const byte *VideoDecoder::getPalette() {
 	_dirtyPalette = false;
 	return _palette;
@@ -224,9 +288,14 @@ const byte *VideoDecoder::getPalette() {
 int VideoDecoder::getCurFrame() const {
 	int32 frame = -1;
 
-	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo)
-			frame += ((VideoTrack *)*it)->getCurFrame() + 1;
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			if (*it == _decodeAheadTrack)
+				frame += _decodeAheadCurFrame + 1;
+			else
+				frame += ((VideoTrack *)*it)->getCurFrame() + 1;
+		}
+	}
 
 	return frame;
 }
@@ -265,7 +334,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime().msecs();
+	uint32 nextFrameStartTime = getNextFrameStartTime(_nextVideoTrack).msecs();
 
 	if (_nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
@@ -283,9 +352,14 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 }
 
 bool VideoDecoder::endOfVideo() const {
-	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->endOfTrack() && ((*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < _endTime))
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() != Track::kTrackTypeVideo) {
+			if (!(*it)->endOfTrack())
+				return false;
+		} else if (!videoTrackEnded((VideoTrack *)*it) && (!_endTimeSet || getNextFrameStartTime((VideoTrack *)*it) < _endTime)) {
 			return false;
+		}
+	}
 
 	return true;
 }
@@ -305,6 +379,8 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	stopDecodeAhead();
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -339,6 +415,8 @@ bool VideoDecoder::seek(const Common::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	stopDecodeAhead();
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -841,9 +919,9 @@ VideoDecoder::VideoTrack *VideoDecoder::findNextVideoTrack() {
 	Common::Timestamp bestTime(0xFFFFFFFF);
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack()) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !videoTrackEnded((VideoTrack *)*it)) {
 			VideoTrack *track = (VideoTrack *)*it;
-			Common::Timestamp time = track->getNextFrameStartTime();
+			Common::Timestamp time = getNextFrameStartTime(track);
 
 			if (time < bestTime) {
 				bestTime = time;
@@ -885,7 +963,7 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack() && (!_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < _endTime))
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !videoTrackEnded((VideoTrack *)*it) && (!_endTimeSet || getNextFrameStartTime((VideoTrack *)*it) < _endTime))
 			return true;
 
 	return false;
@@ -899,4 +977,123 @@ bool VideoDecoder::hasAudio() const {
 	return false;
 }
 
+bool VideoDecoder::startDecodeAhead() {
+	// Frames of several video tracks can only be ordered when shown, so only
+	// decode ahead when there is a single one.
+	VideoTrack *track = 0;
+
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			if (track)
+				return false;
+
+			track = (VideoTrack *)*it;
+		}
+	}
+
+	if (!track || track->isReversed())
+		return false;
+
+	if (_decodeAheadQueue.size() != _decodeAheadFrames + 1) {
+		_decodeAheadQueue.clear();
+		_decodeAheadQueue.resize(_decodeAheadFrames + 1);
+		_decodeAheadHead = 0;
+	}
+
+	_decodeAheadCount = 0;
+	_decodeAheadTrack = track;
+	_decodeAheadCurFrame = track->getCurFrame();
+	return true;
+}
+
+void VideoDecoder::stopDecodeAhead() {
+	// The queue itself is kept, as the caller may still use the frame
+	// shown last
+	_decodeAheadTrack = 0;
+	_decodeAheadCount = 0;
+}
+
+bool VideoDecoder::canDecodeAhead() const {
+	return _decodeAheadCount < _decodeAheadFrames && !_decodeAheadTrack->endOfTrack();
+}
+
+void VideoDecoder::queueNextFrame() {
+	QueuedFrame &frame = _decodeAheadQueue[(_decodeAheadHead + _decodeAheadCount) % _decodeAheadQueue.size()];
+	frame.startTime = _decodeAheadTrack->getNextFrameStartTime();
+
+	uint32 startTime = g_system->getMillis();
+	readNextPacket();
+
+	const Graphics::Surface *surface = _decodeAheadTrack->decodeNextFrame();
+	frame.hasSurface = surface != 0;
+
+	if (surface) {
+		// The track reuses its surface, so keep a copy
+		if (surface->getWidth() == frame.surface.getWidth() && surface->getHeight() == frame.surface.getHeight() && surface->getFormat() == frame.surface.getFormat())
+			frame.surface.copyRectToSurface(surface->getPixels(), surface->getPitch(), 0, 0, surface->getWidth(), surface->getHeight());
+		else
+			frame.surface.copyFrom(*surface);
+	}
+
+	frame.curFrame = _decodeAheadTrack->getCurFrame();
+	frame.dirtyPalette = _decodeAheadTrack->hasDirtyPalette();
+
+	if (frame.dirtyPalette)
+		memcpy(frame.palette, _decodeAheadTrack->getPalette(), sizeof(frame.palette));
+
+	// Keep a running average of the time it takes to decode a frame
+	_decodeAheadFrameTime = (_decodeAheadFrameTime * 3 + (g_system->getMillis() - startTime)) / 4;
+
+	_decodeAheadCount++;
+	_decodeAheadStats.maxQueueDepth = MAX(_decodeAheadStats.maxQueueDepth, _decodeAheadCount);
+}
+
+const Graphics::Surface *VideoDecoder::decodeQueuedFrame() {
+	// Keep the behavior of decodeNextFrame() once the last frame was shown
+	if (!_nextVideoTrack) {
+		readNextPacket();
+		return 0;
+	}
+
+	if (_decodeAheadCount == 0) {
+		// Nothing was decoded ahead in time, decode the frame now
+		queueNextFrame();
+		_decodeAheadStats.lateFrames++;
+	}
+
+	const QueuedFrame *frame = &_decodeAheadQueue[_decodeAheadHead];
+	_decodeAheadHead = (_decodeAheadHead + 1) % _decodeAheadQueue.size();
+	_decodeAheadCount--;
+	_decodeAheadStats.framesShown++;
+
+	_decodeAheadCurFrame = frame->curFrame;
+
+	if (frame->dirtyPalette) {
+		memcpy(_decodeAheadPalette, frame->palette, sizeof(_decodeAheadPalette));
+		_palette = _decodeAheadPalette;
+		_dirtyPalette = true;
+	}
+
+	findNextVideoTrack();
+
+	return frame->hasSurface ? &frame->surface : 0;
+}
+
+bool VideoDecoder::videoTrackEnded(const VideoTrack *track) const {
+	if (track != _decodeAheadTrack)
+		return track->endOfTrack();
+
+	return _decodeAheadCount == 0 && track->endOfTrack();
+}
+
+Common::Timestamp VideoDecoder::getNextFrameStartTime(const VideoTrack *track) const {
+	if (track != _decodeAheadTrack)
+		return track->getNextFrameStartTime();
+
+	if (_decodeAheadCount != 0)
+		return _decodeAheadQueue[_decodeAheadHead].startTime;
+
+	return track->getNextFrameStartTime();
+}
+
 } // End of namespace Video
@@ -31,6 +31,7 @@
 #include "common/str.h"
 #include "common/timestamp.h"
 #include "graphics/pixelformat.h"
+#include "graphics/surface.h"
 
 namespace Audio {
 class AudioStream;
@@ -39,13 +40,10 @@ class SeekableAudioStream;
 }
 
 namespace Common {
+class ReadAheadStream;
 class SeekableReadStream;
 }
 
-namespace Graphics {
-struct Surface;
-}
-
 namespace Video {
 
 /**
@@ -367,6 +365,67 @@ public:
 	 */
 	void setDefaultHighColorFormat(const Graphics::PixelFormat &format) { _defaultHighColorFormat = format; }
 
+	/**
+	 * Set whether loadFile() should read the file ahead, so that disk
+	 * latency does not delay decoding frames. The file is read ahead by
+	 * decodeAhead(), which the caller has to call while waiting for the
+	 * next frame.
+	 *
+	 * By default, VideoDecoder reads the file when the data is needed.
+	 *
+	 * This must be set before calling loadFile().
+	 */
+	void setReadAhead(bool readAhead) { _readAhead = readAhead; }
+
+	/**
+	 * Set how many frames may be decoded ahead of time, so that a frame
+	 * which takes long to decode does not stall playback.
+	 *
+	 * By default, VideoDecoder decodes each frame when decodeNextFrame() is
+	 * called (a frame count of 0).
+	 *
+	 * The frames are decoded by decodeAhead(), which the caller has to call
+	 * while waiting for the next frame. Decoding ahead is only done for
+	 * videos with a single video track playing forward. It begins with the
+	 * first decodeNextFrame() call and restarts after seek(), rewind() and
+	 * setReverse(). While frames are decoded ahead, setReverse() needs to
+	 * seek back to the first frame not shown yet, so it fails for videos
+	 * which cannot seek.
+	 *
+	 * @param frameCount The maximum number of frames to decode ahead
+	 */
+	void setDecodeAhead(uint frameCount);
+
+	/**
+	 * Decode one frame ahead of time, see setDecodeAhead(), or read a block
+	 * of the file ahead, see setReadAhead().
+	 *
+	 * Call this instead of waiting while needsUpdate() returns false. A
+	 * frame is only decoded when there are fewer frames decoded ahead than
+	 * requested, and when decoding it is not expected to delay the frame
+	 * which is due next. Otherwise, the file is read ahead if there is
+	 * room for more data.
+	 *
+	 * @return true if some work was done, false if the caller should wait
+	 */
+	bool decodeAhead();
+
+	/**
+	 * Statistics about decoding ahead, see setDecodeAhead().
+	 */
+	struct DecodeAheadStats {
+		uint32 framesDecoded; ///< Frames decoded ahead by decodeAhead()
+		uint32 framesShown;   ///< Frames returned by decodeNextFrame() while decoding ahead
+		uint32 lateFrames;    ///< Frames which were not ready and had to be decoded on demand
+		uint queueDepth;      ///< Frames currently decoded ahead
+		uint maxQueueDepth;   ///< Most frames decoded ahead at once
+	};
+
+	/**
+	 * Get the statistics about decoding ahead since the video was loaded.
+	 */
+	DecodeAheadStats getDecodeAheadStats() const;
+
 	/**
 	 * Set the video to decode frames in reverse.
 	 *
@@ -930,6 +989,40 @@ private:
 	// Default PixelFormat settings
 	Graphics::PixelFormat _defaultHighColorFormat;
 
+	// Whether loadFile() wraps the file in a ReadAheadStream
+	bool _readAhead;
+	// The stream loadFile() passed to loadStream(), owned by the subclass
+	Common::ReadAheadStream *_readAheadStream;
+
+	// Frames decoded ahead of time, see setDecodeAhead()
+	struct QueuedFrame {
+		Graphics::Surface surface;
+		bool hasSurface;
+		int curFrame;
+		Common::Timestamp startTime;
+		bool dirtyPalette;
+		byte palette[256 * 3];
+	};
+
+	// The frame last returned by decodeNextFrame() stays in the slot before
+	// _decodeAheadHead, so the queue holds at most one less than its size.
+	Common::Array<QueuedFrame> _decodeAheadQueue;
+	uint _decodeAheadHead, _decodeAheadCount;
+	uint _decodeAheadFrames;
+	VideoTrack *_decodeAheadTrack;
+	int _decodeAheadCurFrame;
+	byte _decodeAheadPalette[256 * 3];
+	uint32 _decodeAheadFrameTime; // Average time to decode a frame, in ms
+	DecodeAheadStats _decodeAheadStats;
+
+	bool startDecodeAhead();
+	void stopDecodeAhead();
+	bool canDecodeAhead() const;
+	void queueNextFrame();
+	const Graphics::Surface *decodeQueuedFrame();
+	bool videoTrackEnded(const VideoTrack *track) const;
+	Common::Timestamp getNextFrameStartTime(const VideoTrack *track) const;
+
 	// Internal helper functions
 	void stopAudio();
 	void startAudio();